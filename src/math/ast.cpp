@@ -1,10 +1,7 @@
 #include <algorithm>
 #include <vector>
-#include <sstream>
 #include <unordered_map>
 #include <iostream>
-#include <stack>
-#include <queue>
 #include <functional>
 #include <string>
 #include <numeric>
@@ -65,40 +62,47 @@ Term::Term(term_t type, operation_t op, value_t value) noexcept
 {}
 
 
-std::string Term::to_string() const noexcept
+/**
+ * @brief passes characters of `term` one by one to `append`
+ */
+template<typename Append>
+void render_term(const Term &term, Append &&append)
 {
-	std::stringstream representation;
-
-	if (type == term_t::None)
+	if (term.type == term_t::None)
 	{
-		representation << "None";
-		return representation.str();
-	}
+		for (const char symbol : std::string_view("None"))
+		{
+			append(symbol);
+		}
 
-	if (type == term_t::Function)
-	{
-		representation << operation_dict.at(op);
+		return;
 	}
-	else
+
+	if (term.type == term_t::Function)
 	{
-		if (op == operation_t::Negation)
+		for (const char symbol : operation_dict.at(term.op))
 		{
-			representation << '!';
+			append(symbol);
 		}
 
-		if (type == term_t::Constant)
-		{
-			char suitable_constant = std::abs(value) - 1 + 'a';
-			representation << suitable_constant;
-		}
-		else
-		{
-			char suitable_constant = std::abs(value) - 1 + 'A';
-			representation << suitable_constant;
-		}
+		return;
+	}
+
+	if (term.op == operation_t::Negation)
+	{
+		append('!');
 	}
 
-	return representation.str();
+	const char first = term.type == term_t::Constant ? 'a' : 'A';
+	append(static_cast<char>(std::abs(term.value) - 1 + first));
+}
+
+
+std::string Term::to_string() const noexcept
+{
+	std::string representation;
+	render_term(*this, [&] (char symbol) { representation += symbol; });
+	return representation;
 }
 
 
@@ -113,25 +117,28 @@ Expression::Expression() = default;
 
 Expression::Expression(std::string_view expression)
 {
-	nodes_ = std::move(ExpressionParser(expression).parse().nodes_);
+	auto parsed = ExpressionParser(expression).parse();
+	nodes_ = std::move(parsed.nodes_);
+	fingerprint_ = parsed.fingerprint_;
+	summary_ = parsed.summary_;
 	modified_ = true;
 }
 
 
 Expression::Expression(Term term)
 {
-	nodes_.emplace_back(
-		term,
-		Relation(0)
-	);
+	nodes_.emplace_back(term);
 
+	update_header();
 	modified_ = true;
 }
 
 
 Expression::Expression(const Expression &other)
 	: nodes_(other.nodes_)
-	, representation_(other.representation_)
+	, representation_()
+	, fingerprint_(other.fingerprint_)
+	, summary_(other.summary_)
 	, modified_(true)
 {}
 
@@ -139,20 +146,16 @@ Expression::Expression(const Expression &other)
 Expression::Expression(Expression &&other)
 	: nodes_(std::move(other.nodes_))
 	, representation_(std::move(other.representation_))
+	, fingerprint_(other.fingerprint_)
+	, summary_(other.summary_)
 	, modified_(true)
 {}
 
 
-Expression::Expression(const std::vector<Node> &nodes)
-	: nodes_(nodes)
-{
-	modified_ = true;
-}
-
-
-Expression::Expression(std::vector<Node> &&nodes)
+Expression::Expression(NodeBuffer &&nodes)
 	: nodes_(std::move(nodes))
 {
+	update_header();
 	modified_ = true;
 }
 
@@ -165,6 +168,8 @@ Expression &Expression::operator=(const Expression &other)
 	}
 
 	nodes_ = other.nodes_;
+	fingerprint_ = other.fingerprint_;
+	summary_ = other.summary_;
 	modified_ = true;
 	return *this;
 }
@@ -178,6 +183,8 @@ Expression &Expression::operator=(Expression &&other)
 	}
 
 	nodes_ = std::move(other.nodes_);
+	fingerprint_ = other.fingerprint_;
+	summary_ = other.summary_;
 	modified_ = true;
 	return *this;
 }
@@ -191,88 +198,150 @@ std::size_t Expression::size() const noexcept
 
 std::size_t Expression::operations(operation_t op) const noexcept
 {
-	std::size_t count = 0;
+	return summary_.operations[static_cast<std::size_t>(op)];
+}
 
-	for (const auto &node : nodes_)
+
+bool Expression::empty() const noexcept
+{
+	return nodes_.empty();
+}
+
+
+std::vector<value_t> Expression::variables() const noexcept
+{
+	return ExpressionView(*this).variables();
+}
+
+
+template<typename Append>
+void Expression::render(Append &&append) const
+{
+	walk(0, [&] (std::size_t idx, order_t order)
 	{
-		if (node.term.type != term_t::Function)
+		const bool brackets = idx != 0;
+
+		if (order == order_t::In)
 		{
-			continue;
+			render_term(nodes_[idx].term, append);
 		}
-
-		if (node.term.op == op)
+		else if (brackets)
 		{
-			++count;
+			append(order == order_t::Pre ? '(' : ')');
 		}
-	}
-
-	return count;
+	});
 }
 
 
-bool Expression::empty() const noexcept
+void Expression::recalculate_representation() noexcept
 {
-	return nodes_.empty();
+	if (representation_ == nullptr)
+	{
+		representation_ = std::make_unique<std::string>();
+	}
+
+	representation_->clear();
+	modified_ = false;
+
+	if (empty())
+	{
+		*representation_ = "empty";
+		return;
+	}
+
+	representation_->reserve(2 * size());
+	render([&] (char symbol) { *representation_ += symbol; });
 }
 
 
-std::vector<value_t> Expression::variables() const noexcept
+void Expression::write(std::ostream &out) const
 {
-	std::vector<value_t> vars;
-	vars.reserve(nodes_.size());
+	if (!modified_ && representation_ != nullptr)
+	{
+		out << *representation_;
+		return;
+	}
 
-	for (const auto &node : nodes_)
+	if (empty())
 	{
-		if (node.term.type == term_t::Variable)
-		{
-			vars.push_back(node.term.value);
-		}
+		out << "empty";
+		return;
 	}
 
-	return vars;
+	render([&] (char symbol) { out.put(symbol); });
 }
 
 
-void Expression::recalculate_representation() noexcept
+void Expression::update_header() noexcept
 {
+	fingerprint_ = {};
+	summary_ = {};
+
 	if (empty())
 	{
-		representation_ = "empty";
-		modified_ = false;
 		return;
 	}
 
-	std::stringstream ss;
-	std::function<void(std::ostream &, Relation, const Expression &)> f =
-	[&] (std::ostream &out, Relation root, const Expression &expression)
+	constexpr std::uint64_t multiplier = 0x100000001b3ull;
+	const auto mix = [] (std::uint64_t hash, std::uint64_t token) -> std::uint64_t
+	{
+		hash = (hash ^ token) * multiplier;
+		return hash ^ (hash >> 31);
+	};
+
+	// variables are numbered by first occurrence, leaves have the same
+	// relative order in preorder and inorder traverse, so it matches `normalize`
+	VariableMap<value_t> seen;
+
+	std::uint64_t shape = 0xcbf29ce484222325ull;
+	std::uint64_t naming = 0x84222325cbf29ce4ull;
+
+	// ends of subtrees enclosing current node, its size is node depth
+	SmallStack<std::size_t> ancestors;
+
+	for (std::size_t i = 0; i < nodes_.size(); ++i)
 	{
-		if (root.self() == INVALID_INDEX)
+		const auto &term = nodes_[i].term;
+
+		while (!ancestors.empty() && ancestors.top() <= i)
 		{
-			return;
+			ancestors.pop();
 		}
 
-		const bool brackets = root.parent() != INVALID_INDEX &&
-			expression[root.self()].type == term_t::Function;
-		if (brackets)
+		summary_.depth = std::max(
+			summary_.depth,
+			static_cast<index_t>(ancestors.size() + 1)
+		);
+
+		if (term.type == term_t::Function)
 		{
-			out << "(";
+			ancestors.push(i + nodes_[i].size);
+			++summary_.operations[static_cast<std::size_t>(term.op)];
+		}
+		else if (term.type == term_t::Variable)
+		{
+			summary_.variables |= 1ull << (term.value & 63);
+			summary_.min_value = std::min(summary_.min_value, term.value);
+			summary_.max_value = std::max(summary_.max_value, term.value);
 		}
 
-		f(out, subtree(root.left()), expression);
-		out << expression[root.self()].to_string();
-		f(out, subtree(root.right()), expression);
+		const auto polarity = static_cast<std::uint64_t>(term.op);
+		std::uint64_t value = static_cast<std::uint32_t>(term.value);
 
-		if (brackets)
+		if (term.type == term_t::Variable)
 		{
-			out << ")";
+			value = static_cast<std::uint64_t>(seen.number(term.value));
 		}
 
-		return;
-	};
+		const auto token = term.type == term_t::Function ?
+			polarity << 1 | 1 :
+			(value << 4 | polarity) << 1;
 
-	f(ss, subtree(0), *this);
-	representation_ = std::move(ss.str());
-	modified_ = false;
+		shape = mix(shape, token);
+		naming = mix(naming, token << 2 | static_cast<std::uint64_t>(term.type));
+	}
+
+	fingerprint_ = {shape, naming};
 }
 
 
@@ -283,133 +352,160 @@ std::string Expression::to_string() noexcept
 		recalculate_representation();
 	}
 
-	return representation_;
+	return *representation_;
 }
 
 
 value_t Expression::max_value() const noexcept
 {
-	value_t value = 0;
+	return summary_.max_value;
+}
 
-	// find max value in variables
-	for (const auto &node : nodes_)
-	{
-		if (node.term.type == term_t::Variable)
-		{
-			value = std::max(value, node.term.value);
-		}
-	}
 
-	return value;
+value_t Expression::min_value() const noexcept
+{
+	return summary_.min_value;
 }
 
 
-value_t Expression::min_value() const noexcept
+void Expression::normalize() noexcept
 {
-	value_t min_value = std::numeric_limits<value_t>::max();
+	VariableMap<value_t> remapping;
 
-	// find min value in variables
-	for (const auto &node : nodes_)
+	// leaves are stored in the same order as inorder traverse visits them
+	for (auto &node : nodes_)
 	{
 		if (node.term.type == term_t::Variable)
 		{
-			min_value = std::min(min_value, node.term.value);
+			node.term.value = remapping.number(node.term.value);
 		}
 	}
 
-	return min_value;
+	// variables are 1..n now
+	if (remapping.size() != 0)
+	{
+		const auto count = static_cast<value_t>(remapping.size());
+		summary_.variables = count >= 64 ? ~0ull : ((1ull << count) - 1) << 1;
+		summary_.min_value = 1;
+		summary_.max_value = count;
+	}
+
+	modified_ = true;
 }
 
 
-void Expression::normalize() noexcept
+Expression Expression::canonical() const
 {
-	std::vector<value_t> order;
-	std::unordered_map<value_t, value_t> remapping;
-
-	std::function<void(Relation)> traverse =
-	[&] (Relation node)
+	if (empty())
 	{
-		if (node.self() == INVALID_INDEX)
-		{
-			return;
-		}
+		return {};
+	}
 
-		traverse(subtree(node.left()));
+	constexpr std::uint64_t multiplier = 0x9e3779b97f4a7c15ull;
 
-		if (nodes_[node.self()].term.type == term_t::Variable)
-		{
-			order.push_back(nodes_[node.self()].term.value);
-		}
+	// children follow their parent in preorder, so reverse pass
+	// computes key of every subtree after keys of its children
+	SmallVector<std::uint64_t, INLINE_NODES> keys;
+	keys.reserve(nodes_.size());
+	for (std::size_t i = 0; i < nodes_.size(); ++i)
+	{
+		keys.push_back(0);
+	}
+
+	// operands which come first in canonical order
+	const auto first = [&] (std::size_t idx) -> std::size_t
+	{
+		const auto left = idx + 1;
+		const auto right = left + nodes_[left].size;
 
-		traverse(subtree(node.right()));
+		return is_commutative(nodes_[idx].term.op) &&
+			keys.data()[right] < keys.data()[left] ? right : left;
 	};
-	traverse(subtree(0));
 
-	value_t new_value = 1;
-	for (const auto &entry : order)
+	for (std::size_t i = nodes_.size(); i-- > 0;)
 	{
-		if (remapping.contains(entry))
+		const auto &term = nodes_[i].term;
+		std::uint64_t key = static_cast<std::uint64_t>(term.type) << 8 |
+			static_cast<std::uint64_t>(term.op);
+
+		if (term.type == term_t::Constant)
 		{
-			continue;
+			key |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(term.value)) << 16;
+		}
+
+		if (term.type == term_t::Function)
+		{
+			const auto lhs = first(i);
+			const auto rhs = lhs == i + 1 ? i + 1 + nodes_[i + 1].size : i + 1;
+
+			key = (key * multiplier) ^ keys.data()[lhs];
+			key = (key * multiplier) ^ keys.data()[rhs];
+			key ^= key >> 29;
 		}
 
-		remapping[entry] = new_value;
-		++new_value;
+		keys.data()[i] = key;
 	}
 
-	for (auto &node : nodes_)
+	// subtrees keep their sizes, only order of operands changes
+	NodeBuffer nodes;
+	nodes.reserve(nodes_.size());
+
+	SmallStack<std::size_t> stack;
+	stack.push(0);
+
+	while (!stack.empty())
 	{
-		if (node.term.type != term_t::Variable)
+		const auto idx = stack.top();
+		stack.pop();
+
+		nodes.push_back(nodes_[idx]);
+
+		const auto &term = nodes_[idx].term;
+		if (term.type != term_t::Function)
 		{
 			continue;
 		}
 
-		node.term.value = remapping[node.term.value];
+		const auto lhs = first(idx);
+		stack.push(lhs == idx + 1 ? idx + 1 + nodes_[idx + 1].size : idx + 1);
+		stack.push(lhs);
 	}
 
-	modified_ = true;
+	Expression result(std::move(nodes));
+	result.normalize();
+
+	return result;
 }
 
 
-void Expression::standardize() noexcept
+Fingerprint Expression::canonical_fingerprint() const
 {
-	// bfs traverse
-	std::queue<std::size_t> q;
-	q.push(0);
-
-	while (!q.empty())
-	{
-		const auto node_idx = q.front();
-		q.pop();
+	const auto commutative = std::accumulate(
+		summary_.operations.begin() + static_cast<std::size_t>(operation_t::Disjunction),
+		summary_.operations.end(),
+		std::size_t{0}
+	);
 
-		// skip invalid nodes
-		if (node_idx == INVALID_INDEX)
-		{
-			continue;
-		}
+	return commutative == 0 ? fingerprint_ : canonical().fingerprint();
+}
 
-		if (nodes_[node_idx].term.type != term_t::Function)
-		{
-			continue;
-		}
 
-		if (nodes_[node_idx].term.op == operation_t::Disjunction)
+void Expression::standardize() noexcept
+{
+	// a | b ~ !a > b, nested disjunctions are visited after their parent
+	traverse(0, [&] (std::size_t idx) -> visit_t
+	{
+		if (nodes_[idx].term.op == operation_t::Disjunction &&
+			nodes_[idx].term.type == term_t::Function)
 		{
-			nodes_[node_idx].term.op = operation_t::Implication;
-			negation(subtree(node_idx).left());
+			nodes_[idx].term.op = operation_t::Implication;
+			negate_subtree(subtree(idx).left());
 		}
 
-		// continue standartization if required
-		if (has_left(node_idx))
-		{
-			q.push(subtree(node_idx).left());
-		}
-		if (has_right(node_idx))
-		{
-			q.push(subtree(node_idx).right());
-		}
-	}
+		return visit_t::Both;
+	});
 
+	update_header();
 	modified_ = true;
 }
 
@@ -424,98 +520,70 @@ void Expression::make_permanent() noexcept
 		}
 	}
 
+	update_header();
 	modified_ = true;
 }
 
 
-Relation Expression::subtree(std::size_t idx) const noexcept
-{
-	return in_range(idx) ? nodes_[idx].rel : Relation{};
-}
-
-
-Expression Expression::subtree_copy(std::size_t idx) const noexcept
+void Expression::make_schematic() noexcept
 {
-	std::size_t new_root_index = subtree(idx).self();
-	std::vector<Node> nodes;
-	std::unordered_map<std::size_t, std::size_t> remapping;
-	std::size_t i = 0;
-
-	std::function<void(Relation)> traverse =
-	[&] (Relation node)
+	for (auto &node : nodes_)
 	{
-		if (node.self() == INVALID_INDEX)
+		if (node.term.type == term_t::Constant)
 		{
-			return;
+			node.term.type = term_t::Variable;
 		}
+	}
 
-		// append new node
-		nodes.push_back(nodes_[node.self()]);
-		remapping[node.self()] = i++;
-
-		traverse(subtree(node.left()));
-		traverse(subtree(node.right()));
-	};
-
-	// traverse to collect values of subtree
-	traverse(subtree(new_root_index));
+	update_header();
+	modified_ = true;
+}
 
-	// break relation with old parent
-	nodes[0].rel.refs[3] = INVALID_INDEX;
 
-	// update indices
-	for (auto &node : nodes)
+Relation Expression::subtree(std::size_t idx) const noexcept
+{
+	if (!in_range(idx))
 	{
-		for (auto &ref : node.rel.refs)
-		{
-			if (!remapping.contains(ref))
-			{
-				continue;
-			}
+		return Relation{};
+	}
 
-			ref = remapping.at(ref);
-		}
+	if (nodes_[idx].term.type != term_t::Function)
+	{
+		return Relation{idx};
 	}
 
-	return Expression{std::move(nodes)};
+	return Relation{idx, idx + 1, idx + 1 + nodes_[idx + 1].size};
 }
 
 
-bool Expression::contains(Term term) const noexcept
+Expression Expression::subtree_copy(std::size_t idx) const noexcept
 {
-	// since we check single `term`, then function is not possible
-	if (term.type != term_t::Variable && term.type != term_t::Constant)
+	if (!in_range(idx))
 	{
-		return false;
+		return {};
 	}
 
-	for (const auto &node : nodes_)
-	{
-		if (node.term.type != term_t::Variable &&
-			node.term.type != term_t::Constant)
-		{
-			continue;
-		}
+	// subtree is contiguous and sizes are relative, so no remapping is required
+	const auto first = nodes_.begin() + idx;
+	return Expression{NodeBuffer(first, first + nodes_[idx].size)};
+}
 
-		if (node.term.value == term.value)
-		{
-			return true;
-		}
-	}
 
-	return false;
+bool Expression::contains(Term term) const noexcept
+{
+	return ExpressionView(*this).contains(term);
 }
 
 
 bool Expression::has_left(std::size_t idx) const noexcept
 {
-	return !in_range(idx) ? false : in_range(nodes_[idx].rel.left());
+	return in_range(idx) && nodes_[idx].term.type == term_t::Function;
 }
 
 
 bool Expression::has_right(std::size_t idx) const noexcept
 {
-	return !in_range(idx) ? false : in_range(nodes_[idx].rel.right());
+	return in_range(idx) && nodes_[idx].term.type == term_t::Function;
 }
 
 
@@ -526,53 +594,52 @@ void Expression::negation(std::size_t idx)
 		return;
 	}
 
-	// bfs traverse
-	std::queue<std::size_t> q;
-	q.push(idx);
+	negate_subtree(idx);
 
-	while (!q.empty())
-	{
-		const auto node_idx = q.front();
-		q.pop();
+	update_header();
+	modified_ = true;
+}
 
-		// skip invalid nodes
-		if (node_idx == INVALID_INDEX)
-		{
-			continue;
-		}
 
-		if (nodes_[node_idx].term.type != term_t::Function)
+void Expression::negate_subtree(std::size_t idx) noexcept
+{
+	traverse(idx, [&] (std::size_t node_idx) -> visit_t
+	{
+		auto &term = nodes_[node_idx].term;
+
+		if (term.type != term_t::Function)
 		{
-			nodes_[node_idx].term.op =
-				nodes_[node_idx].term.op == operation_t::Negation ?
+			term.op = term.op == operation_t::Negation ?
 				operation_t::Nop :
 				operation_t::Negation;
 
-			continue;
+			return visit_t::Skip;
 		}
 
 		// inverse operation_t
-		nodes_[node_idx].term.op = opposite(nodes_[node_idx].term.op);
+		term.op = opposite(term.op);
 
 		// continue negation if required
-		if (nodes_[node_idx].term.op == operation_t::Implication ||
-			nodes_[node_idx].term.op == operation_t::Conjunction)
-		{
-			q.push(subtree(node_idx).right());
-		}
-		else if (nodes_[node_idx].term.op == operation_t::Disjunction)
+		if (term.op == operation_t::Implication ||
+			term.op == operation_t::Conjunction)
 		{
-			q.push(subtree(node_idx).left());
-			q.push(subtree(node_idx).right());
+			return visit_t::Right;
 		}
-	}
 
-	modified_ = true;
+		return term.op == operation_t::Disjunction ?
+			visit_t::Both :
+			visit_t::Skip;
+	});
 }
 
 
 void Expression::change_variables(value_t bound)
 {
+	if (summary_.variables == 0)
+	{
+		return;
+	}
+
 	// adjust variables to be at least bound
 	bound -= min_value();
 	for (auto &node : nodes_)
@@ -583,6 +650,10 @@ void Expression::change_variables(value_t bound)
 		}
 	}
 
+	// every variable is moved by the same amount, so bits are rotated
+	summary_.variables = std::rotl(summary_.variables, bound & 63);
+	summary_.min_value += bound;
+	summary_.max_value += bound;
 	modified_ = true;
 }
 
@@ -594,86 +665,68 @@ Expression &Expression::replace(value_t value, const Expression &expression)
 		return *this;
 	}
 
-	std::vector<std::size_t> indices;
-	Expression new_expr = expression;
-	Expression new_expr_neg = new_expr;
+	const bool found = std::ranges::any_of(nodes_, [&] (const auto &node) {
+		return node.term.type == term_t::Variable && node.term.value == value;
+	});
+
+	// nothing to replace
+	if (!found)
+	{
+		return *this;
+	}
+
+	Expression new_expr_neg = expression;
 	new_expr_neg.negation();
 
-	value_t appropriate_value = 0;
+	// rebuild array in preorder, every occurrence is expanded in place
+	NodeBuffer nodes;
+	nodes.reserve(nodes_.size() + 2 * expression.size());
 
-	// find all places
 	for (const auto &node : nodes_)
 	{
-		if (node.term.type == term_t::Variable &&
-			node.term.value == value)
+		if (node.term.type != term_t::Variable || node.term.value != value)
 		{
-			indices.push_back(node.rel.self());
-			appropriate_value = std::max(
-				std::abs(appropriate_value),
-				node.term.value
-			);
+			nodes.push_back(node);
+			continue;
 		}
-	}
 
-	// nothing to replace
-	if (indices.empty())
-	{
-		return *this;
+		const auto &replacement =
+			node.term.op == operation_t::Negation ?
+			new_expr_neg :
+			expression;
+
+		nodes.append(
+			replacement.nodes_.begin(),
+			replacement.nodes_.end()
+		);
 	}
 
-	// don't forget that other variables are different and should not intersect with ours
-	auto offset = size();
-	appropriate_value = appropriate_value + 1;
-	for (const auto &entry : indices)
-	{
-		auto replacement =
-			nodes_[entry].term.op == operation_t::Negation ?
-			new_expr_neg :
-			new_expr;
-
-		nodes_[entry] = Node{
-			replacement.nodes_[0].term,
-			Relation{
-				nodes_[entry].rel.refs[0],
-				increase_index(
-					replacement.subtree(0).left(),
-					offset - 1
-				),
-				increase_index(
-					replacement.subtree(0).right(),
-					offset - 1
-				),
-				nodes_[entry].rel.refs[3]
-			}
-		};
+	nodes_ = std::move(nodes);
+	recalculate_sizes();
 
-		for (std::size_t i = 1; i < replacement.nodes_.size(); ++i)
-		{
-			nodes_.push_back(replacement.nodes_[i]);
-			//nodes_.back().term.value += appropriate_value;
+	update_header();
+	modified_ = true;
+	return *this;
+}
 
-			for (auto &ref : nodes_.back().rel.refs)
-			{
-				ref = increase_index(ref, offset - 1);
-			}
-		}
 
-		// update relations for subroot nodes
-		if (subtree(entry).left() != INVALID_INDEX)
-		{
-			nodes_[subtree(entry).left()].rel.refs[3] = entry;
-		}
-		if (subtree(entry).right() != INVALID_INDEX)
+void Expression::recalculate_sizes() noexcept
+{
+	// children are stored after parent, so reverse order sees them first
+	for (std::size_t i = nodes_.size(); i-- > 0;)
+	{
+		if (nodes_[i].term.type != term_t::Function)
 		{
-			nodes_[subtree(entry).right()].rel.refs[3] = entry;
+			nodes_[i].size = 1;
+			continue;
 		}
 
-		// mode offset
-		offset = nodes_.size();
+		const auto left = i + 1;
+		const auto right = left + nodes_[left].size;
+		nodes_[i].size = static_cast<index_t>(
+			1 + nodes_[left].size + nodes_[right].size
+		);
 	}
-
-	modified_ = true;
-	return *this;
 }
 
 
@@ -684,55 +737,191 @@ Expression Expression::construct(
 )
 {
 	Expression expression;
-	std::size_t offset = 1;
+	expression.nodes_.reserve(1 + lhs.size() + rhs.size());
 
 	expression.nodes_.emplace_back(
 		Term(term_t::Function, op),
-		Relation(0, 1, 1 + lhs.size())
+		1 + lhs.size() + rhs.size()
 	);
+	expression.nodes_.append(lhs.nodes_.begin(), lhs.nodes_.end());
+	expression.nodes_.append(rhs.nodes_.begin(), rhs.nodes_.end());
+
+	expression.update_header();
+	expression.modified_ = true;
+	return expression;
+}
+
+bool Expression::operator<(const Expression &other) const noexcept
+{
+	return size() > other.size();
+}
+
+
+bool Expression::equals(ExpressionView other, bool var_ignore) const noexcept
+{
+	return ExpressionView(*this).equals(other, var_ignore);
+}
+
+
+std::ostream &operator<<(std::ostream &out, const Expression &expression)
+{
+	expression.write(out);
+	return out;
+}
+
+
+ExpressionView::ExpressionView(const Expression &expression) noexcept
+	: nodes_(expression.nodes_.data())
+	, size_(expression.nodes_.size())
+	, summary_(&expression.summary_)
+{}
 
-	for (const auto &node : lhs.nodes_)
+
+ExpressionView::ExpressionView(const Expression &expression, std::size_t idx) noexcept
+{
+	if (!expression.in_range(idx))
 	{
-		expression.nodes_.push_back(node);
+		return;
+	}
 
-		for (auto &ref : expression.nodes_.back().rel.refs)
-		{
-			ref = increase_index(ref, offset);
-		}
+	nodes_ = expression.nodes_.data() + idx;
+	size_ = nodes_[0].size;
+	summary_ = idx == 0 ? &expression.summary_ : nullptr;
+}
+
+
+Relation ExpressionView::subtree(std::size_t idx) const noexcept
+{
+	if (idx >= size_)
+	{
+		return Relation{};
+	}
+
+	if (nodes_[idx].term.type != term_t::Function)
+	{
+		return Relation{idx};
+	}
+
+	return Relation{idx, idx + 1, idx + 1 + nodes_[idx + 1].size};
+}
+
+
+ExpressionView ExpressionView::subview(std::size_t idx) const noexcept
+{
+	ExpressionView view;
+
+	if (idx >= size_)
+	{
+		return view;
+	}
 
-		if (expression.nodes_.back().rel.refs[3] == INVALID_INDEX)
+	view.nodes_ = nodes_ + idx;
+	view.size_ = nodes_[idx].size;
+	view.offset_ = offset_;
+	view.summary_ = idx == 0 ? summary_ : nullptr;
+	return view;
+}
+
+
+ExpressionView ExpressionView::shifted(value_t offset) const noexcept
+{
+	ExpressionView view = *this;
+	view.offset_ = static_cast<value_t>(view.offset_ + offset);
+	return view;
+}
+
+
+std::vector<value_t> ExpressionView::variables() const noexcept
+{
+	std::vector<value_t> vars;
+	vars.reserve(size_);
+
+	for (std::size_t i = 0; i < size_; ++i)
+	{
+		if (nodes_[i].term.type == term_t::Variable)
 		{
-			expression.nodes_.back().rel.refs[3] = 0;
+			vars.push_back((*this)[i].value);
 		}
 	}
 
-	offset += lhs.size();
-	for (const auto &node : rhs.nodes_)
+	return vars;
+}
+
+
+value_t ExpressionView::max_value() const noexcept
+{
+	value_t value = 0;
+
+	if (summary_ != nullptr)
 	{
-		expression.nodes_.push_back(node);
+		return summary_->variables == 0 ? value : std::max(
+			value,
+			static_cast<value_t>(summary_->max_value + offset_)
+		);
+	}
 
-		for (auto &ref : expression.nodes_.back().rel.refs)
+	// find max value in variables
+	for (std::size_t i = 0; i < size_; ++i)
+	{
+		if (nodes_[i].term.type == term_t::Variable)
 		{
-			ref = increase_index(ref, offset);
+			value = std::max(value, (*this)[i].value);
 		}
+	}
 
-		if (expression.nodes_.back().rel.refs[3] == INVALID_INDEX)
+	return value;
+}
+
+
+value_t ExpressionView::min_value() const noexcept
+{
+	value_t min_value = std::numeric_limits<value_t>::max();
+
+	if (summary_ != nullptr)
+	{
+		return summary_->variables == 0 ?
+			min_value :
+			static_cast<value_t>(summary_->min_value + offset_);
+	}
+
+	// find min value in variables
+	for (std::size_t i = 0; i < size_; ++i)
+	{
+		if (nodes_[i].term.type == term_t::Variable)
 		{
-			expression.nodes_.back().rel.refs[3] = 0;
+			min_value = std::min(min_value, (*this)[i].value);
 		}
 	}
 
-	expression.modified_ = true;
-	return expression;
+	return min_value;
 }
 
-bool Expression::operator<(const Expression &other) const noexcept
+
+bool ExpressionView::contains(Term term) const noexcept
 {
-	return size() > other.size();
+	// since we check single `term`, then function is not possible
+	if (term.type != term_t::Variable && term.type != term_t::Constant)
+	{
+		return false;
+	}
+
+	for (std::size_t i = 0; i < size_; ++i)
+	{
+		const auto node = (*this)[i];
+
+		// variables and constants are numbered independently,
+		// so leaf matches only the term of the same type
+		if (node.type == term.type && node.value == term.value)
+		{
+			return true;
+		}
+	}
+
+	return false;
 }
 
 
-bool Expression::equals(const Expression &other, bool var_ignore) const noexcept
+bool ExpressionView::equals(ExpressionView other, bool var_ignore) const noexcept
 {
 	if (size() != other.size())
 	{
@@ -741,26 +930,20 @@ bool Expression::equals(const Expression &other, bool var_ignore) const noexcept
 
 	for (std::size_t i = 0; i < size(); ++i)
 	{
-		if ((nodes_[i].term.type == term_t::Function) !=
-			(other.nodes_[i].term.type == term_t::Function))
-		{
-			return false;
-		}
+		const auto lhs = (*this)[i];
+		const auto rhs = other[i];
 
-		if (nodes_[i].term.type == term_t::Function &&
-			nodes_[i].term.op != other.nodes_[i].term.op)
+		if ((lhs.type == term_t::Function) != (rhs.type == term_t::Function))
 		{
 			return false;
 		}
 
-		if (!var_ignore &&
-			(nodes_[i].term.type != other.nodes_[i].term.type))
+		if (!var_ignore && lhs.type != rhs.type)
 		{
 			return false;
 		}
 
-		if (nodes_[i].term.value != other.nodes_[i].term.value ||
-			nodes_[i].term.op != other.nodes_[i].term.op)
+		if (lhs.value != rhs.value || lhs.op != rhs.op)
 		{
 			return false;
 		}
@@ -770,7 +953,20 @@ bool Expression::equals(const Expression &other, bool var_ignore) const noexcept
 }
 
 
-std::ostream &operator<<(std::ostream &out, Expression &expression)
+Expression ExpressionView::copy() const
 {
-	return out << expression.to_string();
+	Expression::NodeBuffer nodes(nodes_, nodes_ + size_);
+
+	if (offset_ != 0)
+	{
+		for (auto &node : nodes)
+		{
+			if (node.term.type == term_t::Variable)
+			{
+				node.term.value = static_cast<value_t>(node.term.value + offset_);
+			}
+		}
+	}
+
+	return Expression{std::move(nodes)};
 }
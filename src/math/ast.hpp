@@ -7,13 +7,23 @@
 #include <vector>
 #include <array>
 #include <string>
-
-
-using value_t = std::int32_t;
+#include <functional>
+#include <memory>
+#include <limits>
+#include <bit>
+#include "traverse.hpp"
+#include "small_vector.hpp"
+
+
+// node term and relations are packed into small integers:
+// formulas are far below 2^15 variables and 2^16 nodes
+using value_t = std::int16_t;
+using index_t = std::uint16_t;
 constexpr const std::size_t INVALID_INDEX = static_cast<std::size_t>(-1);
+constexpr const index_t INVALID_NODE = static_cast<index_t>(-1);
 
 
-enum class operation_t : std::int32_t
+enum class operation_t : std::uint8_t
 {
 	Nop = 0,
 	Negation,
@@ -25,7 +35,7 @@ enum class operation_t : std::int32_t
 };
 
 
-enum class term_t : std::int32_t
+enum class term_t : std::uint8_t
 {
 	None = 0,
 	Constant,
@@ -67,6 +77,19 @@ std::size_t increase_index(std::size_t index, std::size_t offset);
 std::size_t decrease_index(std::size_t index, std::size_t offset);
 
 
+inline index_t compact_index(std::size_t index) noexcept
+{
+	return index == INVALID_INDEX ? INVALID_NODE : static_cast<index_t>(index);
+}
+
+
+inline std::size_t expand_index(index_t index) noexcept
+{
+	return index == INVALID_NODE ? INVALID_INDEX : index;
+}
+
+
+// 4 bytes: type, operation and value
 struct Term
 {
 	term_t type;
@@ -83,40 +106,119 @@ struct Term
 };
 
 
+// compact references, accessors map INVALID_NODE to INVALID_INDEX
+// @note relation is not stored, it is derived from preorder layout
 struct Relation
 {
-	// references to self,left,right,parent
-	std::array<std::size_t, 4> refs;
+	// references to self,left,right
+	std::array<index_t, 3> refs;
 
 	Relation(std::size_t self = INVALID_INDEX,
 		std::size_t left = INVALID_INDEX,
-		std::size_t right = INVALID_INDEX,
-		std::size_t parent = INVALID_INDEX) noexcept
-		: refs{self, left, right, parent}
+		std::size_t right = INVALID_INDEX) noexcept
+		: refs{
+			compact_index(self),
+			compact_index(left),
+			compact_index(right)
+		}
 	{}
 
-	inline std::size_t self() const noexcept { return refs[0]; }
-	inline std::size_t left() const noexcept { return refs[1]; }
-	inline std::size_t right() const noexcept { return refs[2]; }
-	inline std::size_t parent() const noexcept { return refs[3]; }
+	inline std::size_t self() const noexcept { return expand_index(refs[0]); }
+	inline std::size_t left() const noexcept { return expand_index(refs[1]); }
+	inline std::size_t right() const noexcept { return expand_index(refs[2]); }
+};
+
+
+/**
+ * @brief 128-bit structural hash which ignores variable naming
+ *
+ * @note `shape` covers tree structure, operations, negations and leaf values
+ * after variable normalization, but not the leaf types, therefore
+ * it is equal for expressions accepted by `is_equal`.
+ * `naming` additionally distinguishes constants from variables
+ */
+struct Fingerprint
+{
+	std::uint64_t shape = 0;
+	std::uint64_t naming = 0;
+
+	bool operator==(const Fingerprint &other) const noexcept = default;
+};
+
+
+template<>
+struct std::hash<Fingerprint>
+{
+	std::size_t operator()(const Fingerprint &fingerprint) const noexcept
+	{
+		return fingerprint.shape ^ (fingerprint.naming * 0x9e3779b97f4a7c15ull);
+	}
+};
+
+
+/**
+ * @brief aggregate information kept next to expression nodes
+ *
+ * @note maintained together with the nodes, so filters and renaming
+ * read it without scanning the expression
+ */
+struct Summary
+{
+	// longest root-to-leaf path in nodes
+	index_t depth = 0;
+
+	// number of function nodes per operation
+	std::array<index_t, 7> operations{};
+
+	// bit `v % 64` is set when variable `v` occurs
+	std::uint64_t variables = 0;
+
+	value_t min_value = std::numeric_limits<value_t>::max();
+	value_t max_value = 0;
 };
 
 
+class ExpressionView;
+struct Binding;
+
+
+/**
+ * @brief Binary tree stored as array of nodes in preorder
+ *
+ * @note every subtree occupies contiguous range [idx, idx + size),
+ * left child of function node is idx + 1 and right child follows left subtree
+ */
 class Expression
 {
+	friend class ExpressionView;
+	friend class ExpressionPool;
+
 	struct Node
 	{
 		Term term;
-		Relation rel;
+		// number of nodes in subtree rooted at this node
+		index_t size;
 
-		Node(const Term &term, const Relation &rel) noexcept
-			: term(term), rel(rel)
+		Node(const Term &term, std::size_t size = 1) noexcept
+			: term(term), size(static_cast<index_t>(size))
 		{}
 	};
 
+	static_assert(sizeof(Node) == 6, "node must stay compact");
+
+public:
+	// covers the largest size bound of solver (checked there),
+	// so lemmas it keeps don't allocate
+	static constexpr std::size_t INLINE_NODES = 32;
+	using NodeBuffer = SmallVector<Node, INLINE_NODES>;
+
 private:
-	std::vector<Node> nodes_;
-	std::string representation_;
+	NodeBuffer nodes_;
+
+	// rendered form is allocated on first `to_string`
+	std::unique_ptr<std::string> representation_;
+	Fingerprint fingerprint_;
+	Summary summary_;
 	bool modified_ = true;
 
 	inline bool in_range(std::size_t index) const noexcept
@@ -125,6 +227,20 @@ private:
 	}
 
 	void recalculate_representation() noexcept;
+
+	// pass rendered expression char by char to `append`
+	template<typename Append>
+	void render(Append &&append) const;
+
+	// restore subtree sizes after leaves were expanded
+	void recalculate_sizes() noexcept;
+
+	// refresh fingerprint and summary, must be called by every method
+	// which changes structure, operations or leaf types
+	void update_header() noexcept;
+
+	// negation without fingerprint update
+	void negate_subtree(std::size_t idx) noexcept;
 public:
 	// construction
 	Expression();
@@ -132,8 +248,7 @@ public:
 	Expression(Term term);
 	Expression(const Expression &other);
 	Expression(Expression &&other);
-	Expression(const std::vector<Node> &nodes);
-	Expression(std::vector<Node> &&nodes);
+	Expression(NodeBuffer &&nodes);
 	Expression &operator=(const Expression &other);
 	Expression &operator=(Expression &&other);
 
@@ -148,6 +263,14 @@ public:
  	inline const Term &operator[](std::size_t idx) const { return nodes_[idx].term; }
 	std::string to_string() noexcept;
 
+	// render into stream without caching representation
+	void write(std::ostream &out) const;
+	inline const Fingerprint &fingerprint() const noexcept { return fingerprint_; }
+	inline const Summary &summary() const noexcept { return summary_; }
+
+	// no variables, only constants (hypotheses and permanent targets)
+	inline bool is_ground() const noexcept { return summary_.variables == 0; }
+
 	// max variable value
 	value_t max_value() const noexcept;
 
@@ -158,10 +281,29 @@ public:
 	void normalize() noexcept;
 	void standardize() noexcept;
 	void make_permanent() noexcept;
+	void make_schematic() noexcept;
+
+	// normalized copy where operands of every commutative operation
+	// are ordered by structural key which ignores variable naming
+	Expression canonical() const;
+
+	// equal for expressions which differ only by variable naming
+	// and order of commutative operands
+	Fingerprint canonical_fingerprint() const;
 
 	// relation information
 	Relation subtree(std::size_t idx) const noexcept;
 
+	// iterative preorder traverse of subtree,
+	// `visitor(idx)` returns which children have to be visited
+	template<typename Visitor>
+	void traverse(std::size_t idx, Visitor &&visitor) const;
+
+	// iterative depth-first walk of subtree,
+	// `visitor(idx, order)` is called around and between subtrees
+	template<typename Visitor>
+	void walk(std::size_t idx, Visitor &&visitor) const;
+
 	// deep copy of subtree
 	Expression subtree_copy(std::size_t idx) const noexcept;
 
@@ -180,6 +322,16 @@ public:
 	// replace all occurrences of `value` to `expression
 	Expression &replace(value_t value, const Expression &expression);
 
+	// copy of `expression` built in one pass, every variable is replaced
+	// by `lookup(term)` binding, unbound variables are kept as is;
+	// with `normalize` variables are renumbered while nodes are written
+	template<typename Lookup>
+	static Expression instantiate(
+		ExpressionView expression,
+		Lookup &&lookup,
+		bool normalize = false
+	);
+
 
 	// expression construction
 	static Expression construct(
@@ -192,10 +344,231 @@ public:
 	bool operator<(const Expression &other) const noexcept;
 
 	// compare with other tree
-	bool equals(const Expression &other, bool var_ignore = true) const noexcept;
+	bool equals(ExpressionView other, bool var_ignore = true) const noexcept;
 };
 
 
-std::ostream &operator<<(std::ostream &out, Expression &expression);
+template<typename Visitor>
+void Expression::traverse(std::size_t idx, Visitor &&visitor) const
+{
+	if (!in_range(idx))
+	{
+		return;
+	}
+
+	SmallStack<index_t> stack;
+	stack.push(static_cast<index_t>(idx));
+
+	while (!stack.empty())
+	{
+		const std::size_t current = stack.top();
+		stack.pop();
+
+		const auto next = static_cast<std::uint8_t>(visitor(current));
+		if (nodes_[current].term.type != term_t::Function)
+		{
+			continue;
+		}
+
+		// right is pushed first, so left subtree is visited first
+		const auto rel = subtree(current);
+		if (next & static_cast<std::uint8_t>(visit_t::Right))
+		{
+			stack.push(static_cast<index_t>(rel.right()));
+		}
+		if (next & static_cast<std::uint8_t>(visit_t::Left))
+		{
+			stack.push(static_cast<index_t>(rel.left()));
+		}
+	}
+}
+
+
+template<typename Visitor>
+void Expression::walk(std::size_t idx, Visitor &&visitor) const
+{
+	if (!in_range(idx))
+	{
+		return;
+	}
+
+	SmallStack<std::pair<index_t, order_t>> stack;
+	stack.push({static_cast<index_t>(idx), order_t::Pre});
+
+	while (!stack.empty())
+	{
+		const auto [current, order] = stack.top();
+		stack.pop();
+
+		if (nodes_[current].term.type != term_t::Function)
+		{
+			visitor(current, order_t::In);
+			continue;
+		}
+
+		visitor(current, order);
+
+		const auto rel = subtree(current);
+		if (order == order_t::Pre)
+		{
+			stack.push({current, order_t::In});
+			stack.push({static_cast<index_t>(rel.left()), order_t::Pre});
+		}
+		else if (order == order_t::In)
+		{
+			stack.push({current, order_t::Post});
+			stack.push({static_cast<index_t>(rel.right()), order_t::Pre});
+		}
+	}
+}
+
+
+/**
+ * @brief Non-owning read-only access to expression or to its subtree
+ *
+ * @note view may rename variables apart by `offset` which is added
+ * to every variable value on access, underlying nodes are never copied
+ * and view must not outlive the expression it refers to
+ */
+class ExpressionView
+{
+	friend class Expression;
+
+	const Expression::Node *nodes_ = nullptr;
+	std::size_t size_ = 0;
+	value_t offset_ = 0;
+
+	// set when view covers whole expression, answers range queries in O(1)
+	const Summary *summary_ = nullptr;
+
+public:
+	ExpressionView() = default;
+	ExpressionView(const Expression &expression) noexcept;
+	ExpressionView(const Expression &expression, std::size_t idx) noexcept;
+
+	inline bool empty() const noexcept { return size_ == 0; }
+	inline std::size_t size() const noexcept { return size_; }
+	inline value_t offset() const noexcept { return offset_; }
+
+	inline Term operator[](std::size_t idx) const noexcept
+	{
+		Term term = nodes_[idx].term;
+		if (term.type == term_t::Variable)
+		{
+			term.value = static_cast<value_t>(term.value + offset_);
+		}
+
+		return term;
+	}
+
+	// relation information, indices are relative to view root
+	Relation subtree(std::size_t idx) const noexcept;
+	ExpressionView subview(std::size_t idx) const noexcept;
+
+	// same nodes, variables are additionally moved by offset
+	ExpressionView shifted(value_t offset) const noexcept;
+
+	std::vector<value_t> variables() const noexcept;
+	value_t max_value() const noexcept;
+	value_t min_value() const noexcept;
+	bool contains(Term term) const noexcept;
+	bool equals(ExpressionView other, bool var_ignore = true) const noexcept;
+
+	// owning copy with offset applied
+	Expression copy() const;
+};
+
+
+/**
+ * @brief substituted value of single variable occurrence
+ *
+ * @note empty view means variable is unbound
+ */
+struct Binding
+{
+	ExpressionView view;
+	bool negated = false;
+};
+
+
+template<typename Lookup>
+Expression Expression::instantiate(
+	ExpressionView expression,
+	Lookup &&lookup,
+	bool normalize
+)
+{
+	// every occurrence is looked up once, so result size is known upfront
+	SmallVector<Binding, 16> bindings;
+	std::size_t size = expression.size();
+
+	for (std::size_t i = 0; i < expression.size(); ++i)
+	{
+		if (expression.nodes_[i].term.type != term_t::Variable)
+		{
+			continue;
+		}
+
+		const auto &binding = bindings.emplace_back(lookup(expression[i]));
+		if (!binding.view.empty())
+		{
+			size += binding.view.size() - 1;
+		}
+	}
+
+	Expression result;
+	result.nodes_.reserve(size);
+
+	// nodes are written in final preorder, so first occurrence numbering
+	// gives the same values as `normalize` of the result
+	VariableMap<value_t> remapping;
+	const auto renamed = [&] (Term term) -> Term
+	{
+		if (normalize && term.type == term_t::Variable)
+		{
+			term.value = remapping.number(term.value);
+		}
+
+		return term;
+	};
+
+	auto binding = bindings.begin();
+	for (std::size_t i = 0; i < expression.size(); ++i)
+	{
+		const auto term = expression[i];
+
+		if (term.type != term_t::Variable)
+		{
+			result.nodes_.emplace_back(term);
+			continue;
+		}
+
+		const auto &[view, negated] = *binding++;
+		if (view.empty())
+		{
+			result.nodes_.emplace_back(renamed(term));
+			continue;
+		}
+
+		// bound subtree keeps its sizes, negation only touches its nodes
+		const auto start = result.nodes_.size();
+		for (std::size_t j = 0; j < view.size(); ++j)
+		{
+			result.nodes_.emplace_back(renamed(view[j]), view.nodes_[j].size);
+		}
+
+		if (negated)
+		{
+			result.negate_subtree(start);
+		}
+	}
+
+	result.recalculate_sizes();
+	result.update_header();
+	return result;
+}
+
+
+std::ostream &operator<<(std::ostream &out, const Expression &expression);
 
 #endif // AST_HPP
@@ -0,0 +1,123 @@
+#include <bit>
+#include <algorithm>
+#include "cache.hpp"
+
+
+ModusPonensCache::ModusPonensCache(std::size_t capacity)
+	: shards_()
+	, mask_(std::bit_ceil(std::max<std::size_t>(capacity / SHARDS, PROBES)) - 1)
+	, hits_(0)
+	, misses_(0)
+{
+	for (auto &shard : shards_)
+	{
+		shard.slots.resize(mask_ + 1);
+	}
+}
+
+
+ModusPonensCache &ModusPonensCache::shared()
+{
+	static ModusPonensCache cache;
+	return cache;
+}
+
+
+std::uint64_t ModusPonensCache::key(id_t minor, id_t major) noexcept
+{
+	return static_cast<std::uint64_t>(minor) << 32 | major;
+}
+
+
+std::uint64_t ModusPonensCache::mix(std::uint64_t key) noexcept
+{
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdull;
+	key ^= key >> 33;
+	return key;
+}
+
+
+bool ModusPonensCache::find(id_t minor, id_t major, id_t &result)
+{
+	const auto k = key(minor, major);
+	const auto hash = mix(k);
+	auto &shard = shards_[hash % SHARDS];
+
+	{
+		std::lock_guard lock(shard.mutex);
+
+		for (std::size_t i = 0; i < PROBES; ++i)
+		{
+			const auto &slot = shard.slots[(hash / SHARDS + i) & mask_];
+
+			if (slot.key == k)
+			{
+				result = slot.result;
+				hits_.fetch_add(1, std::memory_order_relaxed);
+				return true;
+			}
+
+			if (slot.key == EMPTY)
+			{
+				break;
+			}
+		}
+	}
+
+	misses_.fetch_add(1, std::memory_order_relaxed);
+	return false;
+}
+
+
+void ModusPonensCache::insert(id_t minor, id_t major, id_t result)
+{
+	const auto k = key(minor, major);
+	const auto hash = mix(k);
+	auto &shard = shards_[hash % SHARDS];
+
+	std::lock_guard lock(shard.mutex);
+
+	// free or same slot is taken first, otherwise the oldest one is evicted
+	Slot *victim = nullptr;
+	for (std::size_t i = 0; i < PROBES; ++i)
+	{
+		auto &slot = shard.slots[(hash / SHARDS + i) & mask_];
+
+		if (slot.key == k || slot.key == EMPTY)
+		{
+			victim = &slot;
+			break;
+		}
+
+		if (victim == nullptr || slot.stamp < victim->stamp)
+		{
+			victim = &slot;
+		}
+	}
+
+	*victim = {k, result, ++shard.clock};
+}
+
+
+void ModusPonensCache::clear()
+{
+	for (auto &shard : shards_)
+	{
+		std::lock_guard lock(shard.mutex);
+		std::ranges::fill(shard.slots, Slot{});
+		shard.clock = 0;
+	}
+
+	hits_ = 0;
+	misses_ = 0;
+}
+
+
+ModusPonensCache::Statistics ModusPonensCache::statistics() const noexcept
+{
+	return {
+		hits_.load(std::memory_order_relaxed),
+		misses_.load(std::memory_order_relaxed)
+	};
+}
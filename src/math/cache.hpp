@@ -0,0 +1,77 @@
+#ifndef CACHE_HPP
+#define CACHE_HPP
+
+#include <cstdint>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "pool.hpp"
+
+
+/**
+ * @brief Bounded memo of modus ponens outcomes keyed by pool ids of premises
+ *
+ * @note table is split into shards guarded by their own mutex,
+ * every shard is open-addressed with short probe sequence; when no free slot
+ * is found, the oldest entry of the sequence is overwritten, so memory
+ * never grows beyond the capacity given on construction
+ */
+class ModusPonensCache
+{
+public:
+	using id_t = ExpressionPool::id_t;
+
+	// outcome of premises which can't be combined
+	static constexpr id_t FAILED = ExpressionPool::INVALID_ID - 1;
+
+	struct Statistics
+	{
+		std::uint64_t hits = 0;
+		std::uint64_t misses = 0;
+	};
+
+private:
+	static constexpr std::size_t SHARDS = 16;
+	static constexpr std::size_t PROBES = 8;
+	static constexpr std::uint64_t EMPTY = static_cast<std::uint64_t>(-1);
+
+	struct Slot
+	{
+		std::uint64_t key = EMPTY;
+		id_t result = FAILED;
+		// insertion order, lower is older
+		std::uint32_t stamp = 0;
+	};
+
+	struct Shard
+	{
+		std::mutex mutex;
+		std::vector<Slot> slots;
+		std::uint32_t clock = 0;
+	};
+
+	std::array<Shard, SHARDS> shards_;
+	std::size_t mask_;
+
+	std::atomic<std::uint64_t> hits_;
+	std::atomic<std::uint64_t> misses_;
+
+	static std::uint64_t key(id_t minor, id_t major) noexcept;
+	static std::uint64_t mix(std::uint64_t key) noexcept;
+public:
+	// capacity is rounded up to power of two per shard
+	explicit ModusPonensCache(std::size_t capacity = 1 << 16);
+
+	// shared by all solvers of the process, its keys are ids of `ExpressionPool::shared`
+	static ModusPonensCache &shared();
+
+	// outcome of `modus_ponens(minor, major)` if it is known
+	bool find(id_t minor, id_t major, id_t &result);
+	void insert(id_t minor, id_t major, id_t result);
+
+	void clear();
+	Statistics statistics() const noexcept;
+};
+
+#endif // CACHE_HPP
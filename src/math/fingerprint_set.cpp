@@ -0,0 +1,237 @@
+#include <bit>
+#include <thread>
+#include <algorithm>
+#include "fingerprint_set.hpp"
+
+
+FingerprintSet::Table::Table(std::size_t capacity)
+	: shapes(std::make_unique<std::atomic<std::uint64_t>[]>(capacity))
+	, namings(std::make_unique<std::atomic<std::uint64_t>[]>(capacity))
+	, mask(capacity - 1)
+	, size(0)
+{
+	for (std::size_t i = 0; i < capacity; ++i)
+	{
+		shapes[i].store(EMPTY, std::memory_order_relaxed);
+		namings[i].store(EMPTY, std::memory_order_relaxed);
+	}
+}
+
+
+FingerprintSet::FingerprintSet(std::size_t capacity, std::size_t bound)
+	: tables_{}
+	, count_(0)
+	, growing_(false)
+	, initial_(std::bit_ceil(std::max<std::size_t>(capacity, 16)))
+	, bound_(std::max(bound, initial_))
+	, slots_(0)
+	, overflows_(0)
+{
+	clear();
+}
+
+
+FingerprintSet::~FingerprintSet()
+{
+	for (auto &table : tables_)
+	{
+		delete table.load(std::memory_order_relaxed);
+	}
+}
+
+
+std::uint64_t FingerprintSet::encode(std::uint64_t word) noexcept
+{
+	// zero is reserved for free slots
+	return word == EMPTY ? 0x9e3779b97f4a7c15ull : word;
+}
+
+
+std::size_t FingerprintSet::hash(std::uint64_t shape, std::uint64_t naming) noexcept
+{
+	auto key = shape ^ (naming * 0xff51afd7ed558ccdull);
+	key ^= key >> 33;
+	return static_cast<std::size_t>(key);
+}
+
+
+std::uint64_t FingerprintSet::naming_of(const Table &table, std::size_t slot) noexcept
+{
+	// owner publishes naming right after claiming the slot
+	std::uint64_t naming;
+	while ((naming = table.namings[slot].load(std::memory_order_acquire)) == EMPTY)
+	{
+		std::this_thread::yield();
+	}
+
+	return naming;
+}
+
+
+bool FingerprintSet::contains(
+	const Table &table,
+	std::uint64_t shape,
+	std::uint64_t naming
+) noexcept
+{
+	const auto start = hash(shape, naming);
+
+	for (std::size_t i = 0; i <= table.mask; ++i)
+	{
+		const auto slot = (start + i) & table.mask;
+		const auto stored = table.shapes[slot].load(std::memory_order_acquire);
+
+		if (stored == EMPTY)
+		{
+			return false;
+		}
+
+		if (stored == shape && naming_of(table, slot) == naming)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+void FingerprintSet::grow(std::size_t last)
+{
+	// single thread grows, the others keep inserting into the last table
+	if (growing_.exchange(true, std::memory_order_acquire))
+	{
+		return;
+	}
+
+	const auto capacity = (tables_[last].load(std::memory_order_relaxed)->mask + 1) * 2;
+
+	if (count_.load(std::memory_order_relaxed) == last + 1 &&
+		last + 1 < MAX_TABLES &&
+		slots_ + capacity <= bound_)
+	{
+		tables_[last + 1].store(new Table(capacity), std::memory_order_release);
+		slots_ += capacity;
+		count_.store(last + 2, std::memory_order_release);
+	}
+
+	growing_.store(false, std::memory_order_release);
+}
+
+
+bool FingerprintSet::insert(const Fingerprint &fingerprint)
+{
+	const auto shape = encode(fingerprint.shape);
+	const auto naming = encode(fingerprint.naming);
+	const auto start = hash(shape, naming);
+
+	while (true)
+	{
+		const auto count = count_.load(std::memory_order_acquire);
+		const auto last = count - 1;
+
+		// older tables receive nothing new, they are only searched
+		for (std::size_t level = 0; level < last; ++level)
+		{
+			if (contains(*tables_[level].load(std::memory_order_acquire), shape, naming))
+			{
+				return false;
+			}
+		}
+
+		auto &table = *tables_[last].load(std::memory_order_acquire);
+
+		// table is kept at most 3/4 full, so probe sequences stay short
+		for (std::size_t i = 0; 4 * table.size.load(std::memory_order_relaxed) < 3 * (table.mask + 1); ++i)
+		{
+			const auto slot = (start + i) & table.mask;
+			auto stored = table.shapes[slot].load(std::memory_order_acquire);
+
+			if (stored == EMPTY &&
+				table.shapes[slot].compare_exchange_strong(stored, shape, std::memory_order_acq_rel))
+			{
+				table.namings[slot].store(naming, std::memory_order_release);
+
+				const auto size = table.size.fetch_add(1, std::memory_order_relaxed) + 1;
+				if (2 * size >= table.mask + 1)
+				{
+					grow(last);
+				}
+
+				return true;
+			}
+
+			if (stored == shape && naming_of(table, slot) == naming)
+			{
+				return false;
+			}
+		}
+
+		// last table is full: continue in the next one, or give up
+		// on storing key when memory bound doesn't allow another table
+		grow(last);
+		if (count_.load(std::memory_order_acquire) == count &&
+			!growing_.load(std::memory_order_acquire))
+		{
+			if (contains(table, shape, naming))
+			{
+				return false;
+			}
+
+			overflows_.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+}
+
+
+bool FingerprintSet::contains(const Fingerprint &fingerprint) const noexcept
+{
+	const auto shape = encode(fingerprint.shape);
+	const auto naming = encode(fingerprint.naming);
+	const auto count = count_.load(std::memory_order_acquire);
+
+	for (std::size_t level = 0; level < count; ++level)
+	{
+		if (contains(*tables_[level].load(std::memory_order_acquire), shape, naming))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+std::size_t FingerprintSet::size() const noexcept
+{
+	std::size_t size = 0;
+	const auto count = count_.load(std::memory_order_acquire);
+
+	for (std::size_t level = 0; level < count; ++level)
+	{
+		size += tables_[level].load(std::memory_order_acquire)->size.load(std::memory_order_relaxed);
+	}
+
+	return size;
+}
+
+
+std::size_t FingerprintSet::overflows() const noexcept
+{
+	return overflows_.load(std::memory_order_relaxed);
+}
+
+
+void FingerprintSet::clear()
+{
+	for (auto &table : tables_)
+	{
+		delete table.exchange(nullptr, std::memory_order_relaxed);
+	}
+
+	tables_[0].store(new Table(initial_), std::memory_order_relaxed);
+	slots_ = initial_;
+	overflows_.store(0, std::memory_order_relaxed);
+	count_.store(1, std::memory_order_release);
+}
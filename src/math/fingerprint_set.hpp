@@ -0,0 +1,96 @@
+#ifndef FINGERPRINT_SET_HPP
+#define FINGERPRINT_SET_HPP
+
+#include <cstdint>
+#include <array>
+#include <atomic>
+#include <memory>
+#include "ast.hpp"
+
+
+/**
+ * @brief Concurrent insert-only set of fingerprints
+ *
+ * @note open addressing over two arrays of atomic words, slot is claimed
+ * by CAS of shape and published by store of naming, so `insert` never
+ * takes a lock. When table gets loaded, next table of double size
+ * is added and receives new keys while older ones are only searched,
+ * nothing is moved and no thread waits for the resize. Total number
+ * of slots never exceeds the bound given on construction, when it is
+ * reached keys which don't fit are reported as new and not stored,
+ * every such answer is counted by `overflows`.
+ * Key which is inserted concurrently with a resize may be reported
+ * as new twice, existing key is never reported as new once stored
+ */
+class FingerprintSet
+{
+	struct Table
+	{
+		std::unique_ptr<std::atomic<std::uint64_t>[]> shapes;
+		std::unique_ptr<std::atomic<std::uint64_t>[]> namings;
+		std::size_t mask;
+		std::atomic<std::size_t> size;
+
+		explicit Table(std::size_t capacity);
+	};
+
+	// 2^MAX_TABLES slots are far beyond any memory bound
+	static constexpr std::size_t MAX_TABLES = 40;
+
+	// zero marks free slot, keys are never zero after `encode`
+	static constexpr std::uint64_t EMPTY = 0;
+
+	std::array<std::atomic<Table *>, MAX_TABLES> tables_;
+	std::atomic<std::size_t> count_;
+	std::atomic<bool> growing_;
+
+	std::size_t initial_;
+	std::size_t bound_;
+	std::size_t slots_;
+
+	// keys reported as new without being stored
+	std::atomic<std::size_t> overflows_;
+
+	static std::uint64_t encode(std::uint64_t word) noexcept;
+	static std::size_t hash(std::uint64_t shape, std::uint64_t naming) noexcept;
+
+	// naming of claimed slot, waits until its owner publishes it
+	static std::uint64_t naming_of(const Table &table, std::size_t slot) noexcept;
+
+	static bool contains(const Table &table, std::uint64_t shape, std::uint64_t naming) noexcept;
+
+	// add next table if `last` is still the last one and bound allows it
+	void grow(std::size_t last);
+
+public:
+	/**
+	 * @param capacity Number of slots of the first table.
+	 * @param bound Maximal number of slots of all tables together.
+	 */
+	explicit FingerprintSet(std::size_t capacity = 1 << 14, std::size_t bound = 1 << 22);
+	~FingerprintSet();
+
+	FingerprintSet(const FingerprintSet &) = delete;
+	FingerprintSet &operator=(const FingerprintSet &) = delete;
+
+	/**
+	 * @brief insert `fingerprint` if it is absent, safe to call concurrently
+	 *
+	 * @return Returns `true` if fingerprint was not in the set.
+	 */
+	bool insert(const Fingerprint &fingerprint);
+	bool contains(const Fingerprint &fingerprint) const noexcept;
+
+	// number of stored fingerprints
+	std::size_t size() const noexcept;
+
+	// number of inserts which found no room within the bound,
+	// their keys may be reported as new again
+	std::size_t overflows() const noexcept;
+
+	// drop all fingerprints and extra tables
+	// @note must not run concurrently with other methods
+	void clear();
+};
+
+#endif // FINGERPRINT_SET_HPP
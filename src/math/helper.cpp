@@ -1,86 +1,115 @@
 #include <unordered_map>
-#include <queue>
-#include <iostream>
-#include <stack>
+#include <limits>
+#include <algorithm>
 #include "helper.hpp"
 
 
-void topological_sort_util(
-	value_t v,
-	std::vector<std::vector<value_t>> &adj,
-	std::vector<bool> &visited,
-	std::stack<value_t> &s
-)
+Binding resolve(Term term, const substitution_t &substitution)
 {
-	visited[v] = true;
+	Binding binding;
 
-	for (value_t i : adj[v])
+	while (term.type == term_t::Variable)
 	{
-		if (!visited[i])
+		const auto it = substitution.find(term.value);
+		if (it == substitution.end())
 		{
-			topological_sort_util(i, adj, visited, s);
+			break;
 		}
+
+		binding.negated ^= term.op == operation_t::Negation;
+		binding.view = ExpressionView(it->second);
+		term = binding.view[0];
 	}
 
-	s.push(v);
+	return binding;
 }
 
 
-std::vector<value_t> topological_sort(
-	std::vector<std::vector<value_t>> &adj,
-	value_t size
-)
+Expression instantiate(ExpressionView expression, const substitution_t &substitution)
 {
-	std::stack<value_t> s;
-	std::vector<bool> visited(size, false);
-	std::vector<value_t> order;
+	return Expression::instantiate(expression, [&] (Term term) -> Binding
+	{
+		return resolve(term, substitution);
+	});
+}
 
-	for (value_t i = 0; i < size; ++i)
+
+constexpr const value_t NO_VARIABLE = -1;
+
+
+/**
+ * @brief root term of binding with its polarity applied
+ *
+ * @note only leaves are negated, function root is used by type only
+ */
+Term term_of(Binding binding) noexcept
+{
+	auto term = binding.view[0];
+
+	if (binding.negated && term.type != term_t::Function)
 	{
-		if (!visited[i])
-		{
-			topological_sort_util(i, adj, visited, s);
-		}
+		term.op = term.op == operation_t::Negation ?
+			operation_t::Nop :
+			operation_t::Negation;
 	}
 
-	while (!s.empty())
+	return term;
+}
+
+
+UnificationContext &UnificationContext::local()
+{
+	static thread_local UnificationContext context;
+	return context;
+}
+
+
+Binding UnificationContext::root(Binding binding) const noexcept
+{
+	auto term = term_of(binding);
+
+	while (term.type == term_t::Variable && !bindings_[term.value].view.empty())
 	{
-		order.push_back(s.top());
-		s.pop();
+		const auto &next = bindings_[term.value];
+		binding = {next.view, next.negated != (term.op == operation_t::Negation)};
+		term = term_of(binding);
 	}
 
-	return order;
+	return binding;
 }
 
 
-bool add_constraint(
-	Term term,
-	Expression substitution,
-	std::unordered_map<value_t, Expression> &sub
-)
+bool UnificationContext::bind(Term variable, Binding binding)
 {
-	if (substitution[0].type == term_t::Function &&
-		substitution.contains(term))
+	if (binding.view[0].type == term_t::Function &&
+		binding.view.contains(variable))
 	{
 		return false;
 	}
 
-	sub[term.value] = substitution;
+	binding.negated ^= variable.op == operation_t::Negation;
+	bindings_[variable.value] = binding;
 	return true;
 }
 
 
-bool unification(
-	Expression left,
-	Expression right,
-	std::unordered_map<value_t, Expression> &substitution
-)
+bool UnificationContext::unify(ExpressionView left, ExpressionView right, value_t reserved)
 {
-	std::unordered_map<value_t, Expression> sub;
+	// rename variables of right apart from left ones, nothing is copied
+	if (right.min_value() != std::numeric_limits<value_t>::max())
+	{
+		right = right.shifted(static_cast<value_t>(
+			left.max_value() + 1 - right.min_value()
+		));
+	}
+	value_t v = std::max({left.max_value(), right.max_value(), reserved}) + 1;
 
-	// change variables to avoid intersections
-	right.change_variables(left.max_value() + 1);
-	value_t v = right.max_value() + 1;
+	bindings_.assign(v, Binding{});
+	mismatches_.clear();
+
+	// every new variable consumes a mismatch, so fresh_ is never reallocated
+	fresh_.clear();
+	fresh_.reserve(std::min(left.size(), right.size()));
 
 	// algorithm
 	// step 1: find the set of mismatches
@@ -88,19 +117,14 @@ bool unification(
 	// goto 1
 	// mismatches can only be in `current`, `left` or `right` subtrees
 	// therefore we will use preorder tree traverse
+	mismatches_.emplace_back(0, 0);
 
-	std::queue<std::pair<std::size_t, std::size_t>> expression;
-	expression.emplace(left.subtree(0).self(), right.subtree(0).self());
-
-	Expression lhs, rhs;
-
-	while (!expression.empty())
+	for (std::size_t next = 0; next < mismatches_.size(); ++next)
 	{
-		auto [left_idx, right_idx] = expression.front();
-		expression.pop();
+		const auto [left_idx, right_idx] = mismatches_[next];
 
-		auto left_term = left[left_idx];
-		auto right_term = right[right_idx];
+		const auto left_term = left[left_idx];
+		const auto right_term = right[right_idx];
 
 		// case 0: both terms are functions
 		if (left_term.type == term_t::Function &&
@@ -113,50 +137,29 @@ bool unification(
 			}
 
 			// add nodes to process
-			expression.emplace(
+			mismatches_.emplace_back(
 				left.subtree(left_idx).left(),
 				right.subtree(right_idx).left()
 			);
-			expression.emplace(
+			mismatches_.emplace_back(
 				left.subtree(left_idx).right(),
 				right.subtree(right_idx).right()
 			);
 			continue;
 		}
 
-		lhs = std::move(left.subtree_copy(left_idx));
-		rhs = std::move(right.subtree_copy(right_idx));
-
 		// adjust terms since it may have subs
-		while (lhs[0].type == term_t::Variable &&
-			sub.contains(lhs[0].value))
-		{
-			bool should_negate = lhs[0].op == operation_t::Negation;
-
-			lhs = sub.at(lhs[0].value);
-			if (should_negate)
-			{
-				lhs.negation();
-			}
-		}
-		while (rhs[0].type == term_t::Variable &&
-			sub.contains(rhs[0].value))
-		{
-			bool should_negate = rhs[0].op == operation_t::Negation;
-
-			rhs = sub.at(rhs[0].value);
-			if (should_negate)
-			{
-				rhs.negation();
-			}
-		}
+		const auto lhs = root({left.subview(left_idx), false});
+		const auto rhs = root({right.subview(right_idx), false});
+		const auto lhs_term = term_of(lhs);
+		const auto rhs_term = term_of(rhs);
 
 		// case 1: both terms are constants
-		if (lhs[0].type == term_t::Constant &&
-			rhs[0].type == term_t::Constant)
+		if (lhs_term.type == term_t::Constant &&
+			rhs_term.type == term_t::Constant)
 		{
 			// can't unify two constants
-			if (lhs[0] != rhs[0])
+			if (lhs_term != rhs_term)
 			{
 				return false;
 			}
@@ -165,39 +168,55 @@ bool unification(
 			continue;
 		}
 
-		// case 2: left term is constant and right is variable
-		if (lhs[0].type == term_t::Constant &&
-			rhs[0].type == term_t::Variable)
+		// case 2: both terms are variables
+		if (lhs_term.type == term_t::Variable &&
+			rhs_term.type == term_t::Variable)
 		{
-			if (rhs[0].op == operation_t::Negation)
+			// are variables equal?
+			if (lhs_term.value == rhs_term.value)
 			{
-				lhs[0].op =
-				lhs[0].op != operation_t::Negation ?
-				operation_t::Negation :
-				operation_t::Nop;
-			}
+				if (lhs_term.op != rhs_term.op)
+				{
+					return false;
+				}
 
-			if (!add_constraint(rhs[0], lhs, sub))
-			{
-				return false;
+				continue;
 			}
 
+			// add new variable, both sides are bound to it
+			// with respect to their polarity
+			const bool lhs_negated = lhs_term.op == operation_t::Negation;
+			const bool rhs_negated = rhs_term.op == operation_t::Negation;
+
+			const auto &expr = fresh_.emplace_back(Term(
+				term_t::Variable,
+				lhs_negated || rhs_negated ?
+				operation_t::Negation :
+				operation_t::Nop,
+				v++
+			));
+			bindings_.emplace_back();
+
+			bindings_[lhs_term.value] = {ExpressionView(expr), lhs_negated};
+			bindings_[rhs_term.value] = {ExpressionView(expr), rhs_negated};
 			continue;
 		}
 
-		// case 3: left term is variable and right is constant
-		if (lhs[0].type == term_t::Variable &&
-			rhs[0].type == term_t::Constant)
+		// case 3: right term is variable, left is constant or function
+		if (rhs_term.type == term_t::Variable)
 		{
-			if (lhs[0].op == operation_t::Negation)
+			if (!bind(rhs_term, lhs))
 			{
-				rhs[0].op =
-				rhs[0].op != operation_t::Negation ?
-				operation_t::Negation :
-				operation_t::Nop;
+				return false;
 			}
 
-			if (!add_constraint(lhs[0], rhs, sub))
+			continue;
+		}
+
+		// case 4: left term is variable, right is constant or function
+		if (lhs_term.type == term_t::Variable)
+		{
+			if (!bind(lhs_term, rhs))
 			{
 				return false;
 			}
@@ -205,175 +224,411 @@ bool unification(
 			continue;
 		}
 
-		// case 4: both terms are variables
-		if (lhs[0].type == term_t::Variable &&
-			rhs[0].type == term_t::Variable)
+		// function can't be unified with constant or bound function
+		return false;
+	}
+
+	return resolve();
+}
+
+
+bool UnificationContext::is_compound(value_t variable) const noexcept
+{
+	const auto &binding = bindings_[variable];
+	return !binding.view.empty() && binding.view[0].type == term_t::Function;
+}
+
+
+value_t UnificationContext::compound_of(Term term) const noexcept
+{
+	while (term.type == term_t::Variable && !bindings_[term.value].view.empty())
+	{
+		if (is_compound(term.value))
 		{
-			// are variables equal?
-			if (lhs[0].value == rhs[0].value)
-			{
-				if (lhs[0].op != rhs[0].op)
-				{
-					return false;
-				}
+			return term.value;
+		}
 
-				continue;
-			}
+		term = bindings_[term.value].view[0];
+	}
 
-			// add new variable
-			Expression expr(Term(
-				term_t::Variable,
-				lhs[0].op == operation_t::Negation ||
-				rhs[0].op == operation_t::Negation ?
-				operation_t::Negation :
-				operation_t::Nop,
-				v++
-			));
-			Expression neg_expr = expr;
-			neg_expr.negation();
+	return NO_VARIABLE;
+}
 
-			if (lhs[0].op == operation_t::Negation)
-			{
-				add_constraint(lhs[0], neg_expr, sub);
-			}
-			else
-			{
-				add_constraint(lhs[0], expr, sub);
-			}
 
-			if (rhs[0].op == operation_t::Negation)
-			{
-				add_constraint(rhs[0], neg_expr, sub);
-			}
-			else
-			{
-				add_constraint(rhs[0], expr, sub);
-			}
+bool UnificationContext::resolve()
+{
+	states_.assign(bindings_.size(), state_t::Unresolved);
+	if (resolved_.size() < bindings_.size())
+	{
+		resolved_.resize(bindings_.size());
+	}
 
-			continue;
+	for (std::size_t variable = 0; variable < bindings_.size(); ++variable)
+	{
+		if (!resolve(static_cast<value_t>(variable)))
+		{
+			return false;
 		}
+	}
 
-		// case 5: left term is function
-		if (lhs[0].type == term_t::Function)
+	return true;
+}
+
+
+bool UnificationContext::resolve(value_t variable)
+{
+	if (!is_compound(variable) || states_[variable] == state_t::Resolved)
+	{
+		return true;
+	}
+
+	// depth-first over bindings, variable is instantiated after
+	// all compound variables it refers to
+	SmallStack<value_t> stack;
+	stack.push(variable);
+
+	while (!stack.empty())
+	{
+		const auto current = stack.top();
+		auto &state = states_[current];
+
+		if (state == state_t::Unresolved)
 		{
-			if (rhs[0].type != term_t::Variable)
-			{
-				return false;
-			}
+			state = state_t::Resolving;
 
-			if (rhs[0].op == operation_t::Negation)
+			const auto view = bindings_[current].view;
+			for (std::size_t i = 0; i < view.size(); ++i)
 			{
-				lhs.negation();
-			}
+				const auto dependency = compound_of(view[i]);
+				if (dependency == NO_VARIABLE || states_[dependency] == state_t::Resolved)
+				{
+					continue;
+				}
 
-			if (!add_constraint(rhs[0], lhs, sub))
-			{
-				return false;
+				// dependency is still on the path, binding is cyclic
+				if (states_[dependency] == state_t::Resolving)
+				{
+					return false;
+				}
+
+				stack.push(dependency);
 			}
 
 			continue;
 		}
 
-		// case 6: right term is function
-		if (rhs[0].type == term_t::Function)
+		stack.pop();
+		if (state == state_t::Resolved)
 		{
-			if (lhs[0].type != term_t::Variable)
-			{
-				return false;
-			}
+			continue;
+		}
 
-			if (lhs[0].op == operation_t::Negation)
-			{
-				rhs.negation();
-			}
+		// binding is negated before its variables are replaced
+		const auto &binding = bindings_[current];
+		Expression negated;
+		auto source = binding.view;
 
-			if (!add_constraint(lhs[0], rhs, sub))
-			{
-				return false;
-			}
+		if (binding.negated)
+		{
+			negated = binding.view.copy();
+			negated.negation();
+			source = ExpressionView(negated);
+		}
 
-			continue;
+		bool cyclic = false;
+		auto instance = Expression::instantiate(source, [&] (Term term) -> Binding
+		{
+			const auto found = lookup(term);
+			cyclic |= found.view.contains(
+				Term(term_t::Variable, operation_t::Nop, term.value)
+			);
+
+			return found;
+		});
+
+		if (cyclic)
+		{
+			return false;
 		}
 
-		// something went wrong during unification?
-		// this point is basically unreachable
-		return false;
+		resolved_[current] = std::move(instance);
+		state = state_t::Resolved;
 	}
 
-	std::vector<std::vector<value_t>> adjacent(v - 1);
-	for (const auto &[u, expr] : sub)
+	return true;
+}
+
+
+Binding UnificationContext::lookup(Term term) const noexcept
+{
+	Binding found;
+	bool negated = false;
+
+	// instantiated expression may have variables which were never unified
+	while (term.type == term_t::Variable &&
+		static_cast<std::size_t>(term.value) < bindings_.size() &&
+		!bindings_[term.value].view.empty())
 	{
-		for (const auto &w : expr.variables())
+		negated ^= term.op == operation_t::Negation;
+
+		if (is_compound(term.value))
 		{
-			adjacent[w - 1].push_back(u - 1);
+			return {ExpressionView(resolved_[term.value]), negated};
 		}
+
+		const auto &binding = bindings_[term.value];
+		found = {binding.view, binding.negated != negated};
+		term = term_of(binding);
 	}
 
-	auto order = topological_sort(adjacent, v - 1);
-	for (auto &variable : order)
+	return found;
+}
+
+
+Expression UnificationContext::instantiate(ExpressionView expression, bool normalize) const
+{
+	return Expression::instantiate(expression, [this] (Term term) -> Binding
 	{
-		variable = variable + 1;
+		return lookup(term);
+	}, normalize);
+}
+
 
-		if (!sub.contains(variable))
+void UnificationContext::export_to(substitution_t &substitution) const
+{
+	substitution.clear();
+
+	for (std::size_t variable = 0; variable < bindings_.size(); ++variable)
+	{
+		const auto &binding = bindings_[variable];
+		if (binding.view.empty())
 		{
 			continue;
 		}
 
-		auto &expr = sub.at(variable);
-		if (expr[0].type != term_t::Function)
+		if (is_compound(static_cast<value_t>(variable)))
 		{
+			substitution.emplace(static_cast<value_t>(variable), resolved_[variable]);
 			continue;
 		}
 
-		for (const auto &var : expr.variables())
+		auto leaf = binding.view.copy();
+		if (binding.negated)
 		{
-			if (!sub.contains(var))
-			{
-				continue;
-			}
+			leaf.negation();
+		}
 
-			auto replacement = sub.at(var);
-			while (replacement[0].type == term_t::Variable &&
-					sub.contains(replacement[0].value))
+		substitution.emplace(static_cast<value_t>(variable), std::move(leaf));
+	}
+}
+
+
+bool unification(
+	ExpressionView left,
+	ExpressionView right,
+	substitution_t &substitution
+)
+{
+	auto &context = UnificationContext::local();
+
+	if (!context.unify(left, right))
+	{
+		return false;
+	}
+
+	context.export_to(substitution);
+	return true;
+}
+
+
+// variable of pattern and the instance subtree it is matched with
+struct Match
+{
+	value_t variable;
+	Binding binding;
+};
+
+
+using matches_t = SmallVector<Match, 16>;
+
+
+bool match(ExpressionView pattern, ExpressionView instance, matches_t &matches)
+{
+	if (pattern.size() > instance.size())
+	{
+		return false;
+	}
+
+	// subtree of instance is skipped at once when variable is met,
+	// so both expressions are walked in preorder simultaneously
+	std::size_t j = 0;
+
+	for (std::size_t i = 0; i < pattern.size(); ++i)
+	{
+		if (j >= instance.size())
+		{
+			return false;
+		}
+
+		const auto term = pattern[i];
+		if (term.type != term_t::Variable)
+		{
+			if (term != instance[j++])
 			{
-				bool should_negate = replacement[0].op == operation_t::Negation;
-				replacement = sub.at(replacement[0].value);
-				if (should_negate)
-				{
-					replacement.negation();
-				}
+				return false;
 			}
 
-			Term to_check(term_t::Variable, operation_t::Nop, var);
-			if (replacement.contains(to_check))
+			continue;
+		}
+
+		const auto subtree = instance.subview(j);
+		const bool negated = term.op == operation_t::Negation;
+		j += subtree.size();
+
+		const auto bound = std::ranges::find(matches, term.value, &Match::variable);
+		if (bound == matches.end())
+		{
+			matches.push_back({term.value, {subtree, negated}});
+			continue;
+		}
+
+		const auto &[view, polarity] = bound->binding;
+		if (polarity == negated)
+		{
+			if (!subtree.equals(view, false))
 			{
 				return false;
 			}
 
-			expr.replace(var, replacement);
+			continue;
+		}
+
+		// occurrences of different polarity, one is negation of other
+		auto opposite = view.copy();
+		opposite.negation();
+
+		if (!subtree.equals(ExpressionView(opposite), false))
+		{
+			return false;
+		}
+	}
+
+	return j == instance.size();
+}
+
+
+bool matching(
+	ExpressionView pattern,
+	ExpressionView instance,
+	substitution_t &substitution
+)
+{
+	matches_t matches;
+	if (!match(pattern, instance, matches))
+	{
+		return false;
+	}
+
+	substitution.clear();
+	for (const auto &[variable, binding] : matches)
+	{
+		auto expr = binding.view.copy();
+		if (binding.negated)
+		{
+			expr.negation();
 		}
+
+		substitution.emplace(variable, std::move(expr));
 	}
 
-	substitution = std::move(sub);
 	return true;
 }
 
 
-bool is_equal(Expression left, Expression right)
+bool is_instance(ExpressionView pattern, ExpressionView instance)
+{
+	matches_t matches;
+	return match(pattern, instance, matches);
+}
+
+
+Expression instantiate_match(
+	ExpressionView pattern,
+	ExpressionView instance,
+	ExpressionView expression,
+	bool normalize
+)
+{
+	matches_t matches;
+	if (!match(pattern, instance, matches))
+	{
+		return {};
+	}
+
+	return Expression::instantiate(expression, [&matches] (Term term) -> Binding
+	{
+		const auto bound = std::ranges::find(matches, term.value, &Match::variable);
+		if (bound == matches.end())
+		{
+			return {};
+		}
+
+		const auto &[view, negated] = bound->binding;
+		return {view, negated != (term.op == operation_t::Negation)};
+	}, normalize);
+}
+
+
+bool is_equal(const Expression &left, const Expression &right)
 {
-	// few O(1) checks
 	if (left.size() != right.size())
 	{
 		return false;
 	}
 
-	if (left[0].op != right[0].op)
+	if (!left.empty() &&
+		left.fingerprint().shape != right.fingerprint().shape)
 	{
 		return false;
 	}
 
-	left.normalize();
-	right.normalize();
+	return is_equal(ExpressionView(left), ExpressionView(right));
+}
+
 
-	return left.equals(right);
+bool is_equal(ExpressionView left, ExpressionView right)
+{
+	if (left.size() != right.size())
+	{
+		return false;
+	}
+
+	// variables of both sides are numbered by first occurrence on the fly,
+	// which is the same as comparing normalized copies
+	VariableMap<value_t> left_order;
+	VariableMap<value_t> right_order;
+
+	const auto normalized = [] (Term term, VariableMap<value_t> &order) -> value_t
+	{
+		return term.type == term_t::Variable ? order.number(term.value) : term.value;
+	};
+
+	for (std::size_t i = 0; i < left.size(); ++i)
+	{
+		const auto lhs = left[i];
+		const auto rhs = right[i];
+
+		if ((lhs.type == term_t::Function) != (rhs.type == term_t::Function) ||
+			lhs.op != rhs.op)
+		{
+			return false;
+		}
+
+		if (normalized(lhs, left_order) != normalized(rhs, right_order))
+		{
+			return false;
+		}
+	}
+
+	return true;
 }
@@ -2,14 +2,110 @@
 #define HELPER_HPP
 
 #include <unordered_map>
+#include <memory_resource>
+#include <vector>
 #include "ast.hpp"
 
 
-bool add_constraint(
-	Term term,
-	Expression substitution,
-	std::unordered_map<value_t, Expression> &sub
-);
+/**
+ * @brief variable value to expression which replaces it
+ *
+ * @note polymorphic allocator lets caller keep bindings in scratch memory
+ */
+using substitution_t = std::pmr::unordered_map<value_t, Expression>;
+
+
+/**
+ * @brief Finds expression which replaces variable `term`
+ *
+ * @note chains of variables bound to variables are followed,
+ * negated occurrences along the chain are accumulated in `negated`
+ */
+Binding resolve(Term term, const substitution_t &substitution);
+
+
+/**
+ * @brief Applies substitution to expression in a single pass
+ *
+ * @param expression The expression to instantiate.
+ * @param substitution Bindings produced by unification.
+ *
+ * @return Returns copy of `expression` with every bound variable replaced.
+ */
+Expression instantiate(ExpressionView expression, const substitution_t &substitution);
+
+
+/**
+ * @brief Reusable state of unification
+ *
+ * @note bindings refer to nodes of unified expressions instead of copies,
+ * negated occurrences are kept as polarity bit (triangular substitution),
+ * results are valid until next `unify` and while unified expressions live.
+ * Buffers are kept between calls, so steady state doesn't allocate
+ */
+class UnificationContext
+{
+	enum class state_t : std::uint8_t
+	{
+		Unresolved = 0,
+		Resolving,
+		Resolved
+	};
+
+	// binding of every variable by its value, empty view if variable is free
+	std::vector<Binding> bindings_;
+
+	// fully instantiated bindings of variables bound to functions
+	std::vector<Expression> resolved_;
+	std::vector<state_t> states_;
+
+	// variables introduced when two variables are unified
+	std::vector<Expression> fresh_;
+
+	// pending pairs of node indices, processed in FIFO order
+	std::vector<std::pair<std::size_t, std::size_t>> mismatches_;
+
+	// follow bindings while root of `binding` is bound variable
+	Binding root(Binding binding) const noexcept;
+
+	// bind free `variable` to `binding`, rejects cyclic function bindings
+	bool bind(Term variable, Binding binding);
+
+	bool is_compound(value_t variable) const noexcept;
+
+	// variable bound to function at the end of binding chain of `term`
+	value_t compound_of(Term term) const noexcept;
+
+	// instantiate function bindings in dependency order
+	bool resolve();
+	bool resolve(value_t variable);
+
+	// binding of variable occurrence after `resolve`
+	Binding lookup(Term term) const noexcept;
+
+public:
+	// context of calling thread
+	static UnificationContext &local();
+
+	/**
+	 * @brief unify `right` to `left`, variables of `right` are renamed apart
+	 *
+	 * @param reserved Variables introduced by unification are numbered above it,
+	 * so renamed expressions which share variables with `right` stay apart.
+	 *
+	 * @note `right` is shifted by `left.max_value() + 1 - right.min_value()`
+	 *
+	 * @return Returns `true` if unification was successful, `false` otherwise.
+	 */
+	bool unify(ExpressionView left, ExpressionView right, value_t reserved = 0);
+
+	// apply bindings of last successful `unify` to `expression`,
+	// variables of result are numbered from 1 if `normalize` is set
+	Expression instantiate(ExpressionView expression, bool normalize = false) const;
+
+	// bindings of last successful `unify` as substitution map
+	void export_to(substitution_t &substitution) const;
+};
 
 
 /**
@@ -25,22 +121,61 @@ bool add_constraint(
  * @return Returns `true` if unification was successful, `false` otherwise.
  */
 bool unification(
-	Expression left,
-	Expression right,
-	std::unordered_map<value_t, Expression> &substitution
+	ExpressionView left,
+	ExpressionView right,
+	substitution_t &substitution
+);
+
+
+/**
+ * @brief One-way matching, binds only variables of `pattern`
+ *
+ * @param pattern The general expression.
+ * @param instance The expression to be matched, its variables are rigid.
+ * @param substitution A reference to a map where the resulting substitution will be stored.
+ *
+ * @note cheaper than `unification`: single linear pass, no renaming
+ * and no resolution of bindings
+ *
+ * @return Returns `true` if `instance` is substitution instance of `pattern`.
+ */
+bool matching(
+	ExpressionView pattern,
+	ExpressionView instance,
+	substitution_t &substitution
+);
+bool is_instance(ExpressionView pattern, ExpressionView instance);
+
+
+/**
+ * @brief Matches `pattern` to `instance` and applies its bindings to `expression`
+ *
+ * @note variables of `expression` absent in `pattern` are kept as is,
+ * so `pattern` and `expression` are usually parts of one formula;
+ * variables of result are numbered from 1 if `normalize` is set
+ *
+ * @return Returns instantiated `expression` or empty expression if there is no match.
+ */
+Expression instantiate_match(
+	ExpressionView pattern,
+	ExpressionView instance,
+	ExpressionView expression,
+	bool normalize = false
 );
 
 
 /**
  * @brief Check if left and right expressions are the same
  *
- * @note unification of variables is allowed
+ * @note unification of variables is allowed,
+ * expressions with different fingerprints are rejected without normalization
  *
  * @param left The left-hand side expression.
  * @param right The right-hand side expression.
  *
  * @return Returns `true` if expressions are equal and `false` otherwise.
  */
-bool is_equal(Expression left, Expression right);
+bool is_equal(const Expression &left, const Expression &right);
+bool is_equal(ExpressionView left, ExpressionView right);
 
 #endif // HELPER_HPP
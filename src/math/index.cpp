@@ -0,0 +1,217 @@
+#include <algorithm>
+#include "index.hpp"
+
+
+DiscriminationTree::DiscriminationTree()
+	: nodes_(1)
+	, size_(0)
+	, pending_()
+	, skipping_()
+{}
+
+
+DiscriminationTree::key_t DiscriminationTree::key(Term term) noexcept
+{
+	if (term.type == term_t::Variable)
+	{
+		return WILDCARD;
+	}
+
+	// type and operation fit into low bits, value is shifted away from them
+	return static_cast<key_t>(term.type) |
+		static_cast<key_t>(term.op) << 2 |
+		static_cast<key_t>(static_cast<std::uint16_t>(term.value)) << 5;
+}
+
+
+bool DiscriminationTree::is_function(key_t key) noexcept
+{
+	return (key & 3) == static_cast<key_t>(term_t::Function);
+}
+
+
+DiscriminationTree::node_t DiscriminationTree::child(node_t node, key_t key) const noexcept
+{
+	for (const auto &[symbol, next] : nodes_[node].children)
+	{
+		if (symbol == key)
+		{
+			return next;
+		}
+	}
+
+	return INVALID_CHILD;
+}
+
+
+void DiscriminationTree::insert(ExpressionView expression, value_type value)
+{
+	node_t node = 0;
+
+	for (std::size_t i = 0; i < expression.size(); ++i)
+	{
+		const auto symbol = key(expression[i]);
+		auto next = child(node, symbol);
+
+		if (next == INVALID_CHILD)
+		{
+			next = static_cast<node_t>(nodes_.size());
+			nodes_[node].children.emplace_back(symbol, next);
+			nodes_.emplace_back();
+		}
+
+		node = next;
+	}
+
+	nodes_[node].values.push_back(value);
+	++size_;
+}
+
+
+void DiscriminationTree::erase(ExpressionView expression, value_type value)
+{
+	node_t node = 0;
+
+	for (std::size_t i = 0; i < expression.size() && node != INVALID_CHILD; ++i)
+	{
+		node = child(node, key(expression[i]));
+	}
+
+	if (node == INVALID_CHILD)
+	{
+		return;
+	}
+
+	auto &values = nodes_[node].values;
+	const auto it = std::ranges::find(values, value);
+
+	if (it != values.end())
+	{
+		values.erase(it);
+		--size_;
+	}
+}
+
+
+void DiscriminationTree::skip_term(node_t node, std::size_t position)
+{
+	skipping_.clear();
+	skipping_.emplace_back(node, 1);
+
+	while (!skipping_.empty())
+	{
+		const auto [current, left] = skipping_.back();
+		skipping_.pop_back();
+
+		for (const auto &[symbol, next] : nodes_[current].children)
+		{
+			// function opens two more terms, leaf closes one
+			const auto rest = left - 1 + (is_function(symbol) ? 2 : 0);
+
+			if (rest == 0)
+			{
+				pending_.emplace_back(next, position);
+			}
+			else
+			{
+				skipping_.emplace_back(next, rest);
+			}
+		}
+	}
+}
+
+
+void DiscriminationTree::retrieve(ExpressionView query, std::vector<value_type> &values)
+{
+	collect(query, values, mode_t::Unifiable);
+}
+
+
+void DiscriminationTree::generalizations(ExpressionView query, std::vector<value_type> &values)
+{
+	collect(query, values, mode_t::Generalization);
+}
+
+
+void DiscriminationTree::instances(ExpressionView query, std::vector<value_type> &values)
+{
+	collect(query, values, mode_t::Instance);
+}
+
+
+void DiscriminationTree::collect(
+	ExpressionView query,
+	std::vector<value_type> &values,
+	mode_t mode
+)
+{
+	if (query.empty() || size_ == 0)
+	{
+		return;
+	}
+
+	pending_.clear();
+	pending_.emplace_back(0, 0);
+
+	while (!pending_.empty())
+	{
+		const auto [node, position] = pending_.back();
+		pending_.pop_back();
+
+		// query is consumed, so is the stored term
+		if (position == query.size())
+		{
+			values.insert(
+				values.end(),
+				nodes_[node].values.begin(),
+				nodes_[node].values.end()
+			);
+			continue;
+		}
+
+		const auto term = query[position];
+		const auto wildcard = child(node, WILDCARD);
+
+		// variable of query may stand for any stored subterm,
+		// unless stored expression has to be more general
+		if (term.type == term_t::Variable)
+		{
+			if (mode != mode_t::Generalization)
+			{
+				skip_term(node, position + 1);
+			}
+			else if (wildcard != INVALID_CHILD)
+			{
+				pending_.emplace_back(wildcard, position + 1);
+			}
+
+			continue;
+		}
+
+		// stored variable may stand for whole query subterm,
+		// unless stored expression has to be an instance
+		if (wildcard != INVALID_CHILD && mode != mode_t::Instance)
+		{
+			pending_.emplace_back(wildcard, position + query.subview(position).size());
+		}
+
+		const auto exact = child(node, key(term));
+		if (exact != INVALID_CHILD)
+		{
+			pending_.emplace_back(exact, position + 1);
+		}
+	}
+}
+
+
+void DiscriminationTree::clear()
+{
+	nodes_.assign(1, Node{});
+	size_ = 0;
+}
+
+
+std::size_t DiscriminationTree::size() const noexcept
+{
+	return size_;
+}
@@ -0,0 +1,83 @@
+#ifndef INDEX_HPP
+#define INDEX_HPP
+
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include "ast.hpp"
+
+
+/**
+ * @brief Discrimination tree over expressions written in preorder
+ *
+ * @note every variable is stored as a wildcard and repeated variables
+ * are not checked, therefore retrieval returns a superset of expressions
+ * unifiable with query: at every position reached through equal
+ * operations neither constants nor operations differ
+ */
+class DiscriminationTree
+{
+public:
+	using value_type = std::uint32_t;
+
+private:
+	using key_t = std::uint32_t;
+	using node_t = std::uint32_t;
+
+	struct Node
+	{
+		// few distinct symbols follow each prefix, so lookup is linear
+		std::vector<std::pair<key_t, node_t>> children;
+		std::vector<value_type> values;
+	};
+
+	enum class mode_t : std::uint8_t
+	{
+		Unifiable = 0,
+		Generalization,
+		Instance
+	};
+
+	static constexpr key_t WILDCARD = 0;
+	static constexpr node_t INVALID_CHILD = static_cast<node_t>(-1);
+
+	std::vector<Node> nodes_;
+	std::size_t size_;
+
+	// retrieval state is kept between calls to avoid allocations:
+	// trie node with query position, and trie node with number of
+	// stored terms which are left to skip
+	std::vector<std::pair<node_t, std::size_t>> pending_;
+	std::vector<std::pair<node_t, std::size_t>> skipping_;
+
+	static key_t key(Term term) noexcept;
+	static bool is_function(key_t key) noexcept;
+
+	node_t child(node_t node, key_t key) const noexcept;
+
+	// continue retrieval from every node which ends one stored term after `node`
+	void skip_term(node_t node, std::size_t position);
+
+	void collect(ExpressionView query, std::vector<value_type> &values, mode_t mode);
+public:
+	DiscriminationTree();
+
+	void insert(ExpressionView expression, value_type value);
+
+	// remove value stored for expression, trie nodes are kept
+	void erase(ExpressionView expression, value_type value);
+
+	// append values of expressions which may unify with `query`
+	void retrieve(ExpressionView query, std::vector<value_type> &values);
+
+	// append values of expressions which `query` may be instance of
+	void generalizations(ExpressionView query, std::vector<value_type> &values);
+
+	// append values of expressions which may be instances of `query`
+	void instances(ExpressionView query, std::vector<value_type> &values);
+
+	void clear();
+	std::size_t size() const noexcept;
+};
+
+#endif // INDEX_HPP
@@ -0,0 +1,153 @@
+#include <cassert>
+#include <functional>
+#include "pool.hpp"
+
+
+bool ExpressionPool::Entry::operator==(const Entry &other) const noexcept
+{
+	return term == other.term && left == other.left && right == other.right;
+}
+
+
+std::size_t ExpressionPool::EntryHash::operator()(const Entry &entry) const noexcept
+{
+	// type and operation fit into low bits, value is shifted away from them
+	std::uint64_t key = static_cast<std::uint64_t>(entry.term.type) |
+		static_cast<std::uint64_t>(entry.term.op) << 2 |
+		static_cast<std::uint64_t>(static_cast<std::uint32_t>(entry.term.value)) << 5;
+
+	key ^= (static_cast<std::uint64_t>(entry.left) << 32 | entry.right) *
+		0x9e3779b97f4a7c15ull;
+
+	return std::hash<std::uint64_t>{}(key ^ (key >> 29));
+}
+
+
+ExpressionPool::ExpressionPool() = default;
+
+
+ExpressionPool &ExpressionPool::shared()
+{
+	static ExpressionPool pool;
+	return pool;
+}
+
+
+ExpressionPool::id_t ExpressionPool::intern(const Expression &expression, std::size_t idx)
+{
+	const auto node = expression.subtree(idx);
+	Entry entry{expression[idx], INVALID_ID, INVALID_ID};
+
+	if (node.left() != INVALID_INDEX)
+	{
+		entry.left = intern(expression, node.left());
+	}
+	if (node.right() != INVALID_INDEX)
+	{
+		entry.right = intern(expression, node.right());
+	}
+
+	entry.size = static_cast<index_t>(expression.nodes_[idx].size);
+
+	const auto [it, inserted] = ids_.emplace(
+		entry,
+		static_cast<id_t>(entries_.size())
+	);
+
+	if (inserted)
+	{
+		entries_.push_back(entry);
+	}
+
+	return it->second;
+}
+
+
+ExpressionPool::id_t ExpressionPool::find(const Expression &expression, std::size_t idx) const
+{
+	const auto node = expression.subtree(idx);
+	Entry entry{expression[idx], INVALID_ID, INVALID_ID};
+
+	if (node.left() != INVALID_INDEX &&
+		(entry.left = find(expression, node.left())) == INVALID_ID)
+	{
+		return INVALID_ID;
+	}
+	if (node.right() != INVALID_INDEX &&
+		(entry.right = find(expression, node.right())) == INVALID_ID)
+	{
+		return INVALID_ID;
+	}
+
+	const auto it = ids_.find(entry);
+	return it == ids_.end() ? INVALID_ID : it->second;
+}
+
+
+ExpressionPool::id_t ExpressionPool::intern(const Expression &expression)
+{
+	if (owner_ == std::thread::id{})
+	{
+		owner_ = std::this_thread::get_id();
+	}
+	assert(owner_ == std::this_thread::get_id() && "pool is interned by one thread only");
+
+	return expression.empty() ? INVALID_ID : intern(expression, 0);
+}
+
+
+void ExpressionPool::clear()
+{
+	entries_.clear();
+	ids_.clear();
+	owner_ = std::thread::id{};
+}
+
+
+ExpressionPool::id_t ExpressionPool::find(const Expression &expression) const
+{
+	return expression.empty() ? INVALID_ID : find(expression, 0);
+}
+
+
+Expression ExpressionPool::expression(id_t id) const
+{
+	if (id >= entries_.size())
+	{
+		return {};
+	}
+
+	// entries are written in preorder with their stored sizes,
+	// so expression is built in one pass without intermediate copies
+	Expression::NodeBuffer nodes;
+	nodes.reserve(entries_[id].size);
+
+	SmallStack<id_t> stack;
+	stack.push(id);
+
+	while (!stack.empty())
+	{
+		const auto &entry = entries_[stack.top()];
+		stack.pop();
+
+		nodes.emplace_back(entry.term, entry.size);
+
+		// negation has the left child only
+		if (entry.right != INVALID_ID)
+		{
+			stack.push(entry.right);
+		}
+		if (entry.left != INVALID_ID)
+		{
+			stack.push(entry.left);
+		}
+	}
+
+	return Expression{std::move(nodes)};
+}
+
+
+std::size_t ExpressionPool::size() const noexcept
+{
+	return entries_.size();
+}
@@ -0,0 +1,74 @@
+#ifndef POOL_HPP
+#define POOL_HPP
+
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include <unordered_map>
+#include <thread>
+#include "ast.hpp"
+
+
+/**
+ * @brief Hash-consed storage of expressions
+ *
+ * @note every distinct subtree is stored once and gets stable 32-bit id,
+ * therefore two expressions are structurally identical iff their ids are equal
+ */
+class ExpressionPool
+{
+public:
+	using id_t = std::uint32_t;
+	static constexpr id_t INVALID_ID = static_cast<id_t>(-1);
+
+	struct Entry
+	{
+		Term term;
+		id_t left;
+		id_t right;
+
+		// number of nodes, derived from children and not part of identity
+		index_t size = 1;
+
+		bool operator==(const Entry &other) const noexcept;
+	};
+
+private:
+	struct EntryHash
+	{
+		std::size_t operator()(const Entry &entry) const noexcept;
+	};
+
+	std::vector<Entry> entries_;
+	std::unordered_map<Entry, id_t, EntryHash> ids_;
+
+	// thread which interns, set by the first `intern` after construction or `clear`
+	std::thread::id owner_;
+
+	id_t intern(const Expression &expression, std::size_t idx);
+	id_t find(const Expression &expression, std::size_t idx) const;
+public:
+	ExpressionPool();
+
+	// pool shared by all solvers of the process, so ids outlive single run
+	// @note not synchronized: one thread interns, others may only read
+	// while it doesn't intern; owner is checked by assertion
+	static ExpressionPool &shared();
+
+	// id of expression, expression is added if it was not seen before
+	id_t intern(const Expression &expression);
+
+	// drop all expressions and owner, ids given before become invalid
+	void clear();
+
+	// id of expression or INVALID_ID if expression is unknown
+	id_t find(const Expression &expression) const;
+
+	// build expression back from its id
+	Expression expression(id_t id) const;
+
+	const Entry &operator[](id_t id) const { return entries_[id]; }
+	std::size_t size() const noexcept;
+};
+
+#endif // POOL_HPP
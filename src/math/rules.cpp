@@ -1,4 +1,6 @@
 #include <iostream>
+#include <cassert>
+#include <limits>
 #include <queue>
 #include <unordered_map>
 #include <string>
@@ -19,46 +21,48 @@ Expression modus_ponens(const Expression &lhs, const Expression &rhs)
 		return {};
 	}
 
-	// try to apply unification
-	std::unordered_map<value_t, Expression> substitution;
-	if (!unification(
-		lhs,
-		rhs.subtree_copy(rhs.subtree(0).left()),
-		substitution))
-	{
-		return {};
-	}
+	const auto antecedent = ExpressionView(rhs, rhs.subtree(0).left());
 
-	// unification succeeded, let's apply changes
-	auto result = rhs;
-	result.change_variables(lhs.max_value() + 1);
-	auto vars = result.variables();
-
-	for (const auto &var : vars)
+	// ground formula has nothing to rename or bind on its side,
+	// so one-way matching replaces unification
+	if (rhs.is_ground())
 	{
-		if (!substitution.contains(var))
+		if (!is_instance(lhs, antecedent))
 		{
-			continue;
+			return {};
 		}
 
-		auto change = substitution.at(var);
-		while (change[0].type == term_t::Variable &&
-			substitution.contains(change[0].value))
-		{
-			bool should_negate = change[0].op == operation_t::Negation;
-			change = substitution.at(change[0].value);
-			if (should_negate)
-			{
-				change.negation();
-			}
-		}
+		return rhs.subtree_copy(rhs.subtree(0).right());
+	}
 
-		result.replace(var, change);
+	if (lhs.is_ground())
+	{
+		return instantiate_match(
+			antecedent,
+			lhs,
+			ExpressionView(rhs, rhs.subtree(0).right()),
+			true
+		);
 	}
 
-	// prepare answer
-	result = result.subtree_copy(result.subtree(0).right());
-	result.normalize();
+	// consequent is renamed apart with the offset unifier applies to antecedent,
+	// offsets are equal when the smallest variable of major premise is in antecedent
+	assert(
+		antecedent.min_value() == std::numeric_limits<value_t>::max() ||
+		antecedent.min_value() == rhs.min_value()
+	);
+	const auto consequent = ExpressionView(rhs, rhs.subtree(0).right()).shifted(
+		static_cast<value_t>(lhs.max_value() + 1 - rhs.min_value())
+	);
+
+	// try to apply unification, context of this thread is reused;
+	// variables it introduces must not meet variables of consequent
+	auto &context = UnificationContext::local();
+	if (!context.unify(lhs, antecedent, consequent.max_value()))
+	{
+		return {};
+	}
 
-        return result;
+	// consequent is written already normalized, without copies
+	return context.instantiate(consequent, true);
 }
@@ -7,6 +7,10 @@
 // 2 variables
 /**
  * @brief a, a > b ⊢ b
+ *
+ * @note smallest variable of major premise `b` must occur in its antecedent,
+ * which holds for every normalized formula; consequent is renamed apart
+ * with the offset of antecedent, checked by assertion
  */
 Expression modus_ponens(const Expression &a, const Expression &b);
 
@@ -0,0 +1,155 @@
+#include "schema.hpp"
+
+
+namespace
+{
+	constexpr std::uint8_t NO_SLOT = static_cast<std::uint8_t>(-1);
+}
+
+
+CompiledSchema::CompiledSchema(Expression schema)
+	: schema_(std::move(schema))
+	, matcher_()
+	, compiled_(false)
+{
+	slots_.fill(NO_SLOT);
+
+	if (schema_.empty() ||
+		schema_[0].type != term_t::Function ||
+		schema_[0].op != operation_t::Implication)
+	{
+		return;
+	}
+
+	// slots are indexed by variable value, so values must be small
+	schema_.normalize();
+	if (schema_.max_value() > static_cast<value_t>(MAX_VARIABLES))
+	{
+		return;
+	}
+
+	const auto antecedent = ExpressionView(schema_, schema_.subtree(0).left());
+	matcher_.reserve(antecedent.size());
+
+	// one instruction per node of antecedent, in preorder
+	std::uint8_t used = 0;
+	for (std::size_t i = 0; i < antecedent.size(); ++i)
+	{
+		const auto term = antecedent[i];
+
+		if (term.type != term_t::Variable)
+		{
+			matcher_.push_back({opcode_t::Node, term, NO_SLOT});
+			continue;
+		}
+
+		auto &slot = slots_[term.value];
+		if (slot == NO_SLOT)
+		{
+			slot = used++;
+			matcher_.push_back({opcode_t::Bind, term, slot});
+			continue;
+		}
+
+		matcher_.push_back({opcode_t::Check, term, slot});
+	}
+
+	compiled_ = true;
+}
+
+
+CompiledSchema::result_t CompiledSchema::apply(const Expression &minor, Expression &result) const
+{
+	if (!compiled_ || minor.empty())
+	{
+		return result_t::Unknown;
+	}
+
+	const ExpressionView instance(minor);
+	std::array<Binding, MAX_VARIABLES> bound;
+	std::size_t j = 0;
+
+	for (const auto &[code, term, slot] : matcher_)
+	{
+		if (j >= instance.size())
+		{
+			return result_t::Mismatch;
+		}
+
+		if (code == opcode_t::Node)
+		{
+			const auto node = instance[j++];
+			if (node == term)
+			{
+				continue;
+			}
+
+			// variable of minor premise may still be bound by unification
+			return node.type == term_t::Variable ?
+				result_t::Unknown :
+				result_t::Mismatch;
+		}
+
+		const auto subtree = instance.subview(j);
+		const bool negated = term.op == operation_t::Negation;
+		j += subtree.size();
+
+		if (code == opcode_t::Bind)
+		{
+			// unifier negates variable of minor premise instead,
+			// its result differs by renaming only, but it is kept as is
+			if (subtree[0].type == term_t::Variable &&
+				(subtree[0].op == operation_t::Negation) != negated)
+			{
+				return result_t::Unknown;
+			}
+
+			bound[slot] = {subtree, negated};
+			continue;
+		}
+
+		const auto &[view, polarity] = bound[slot];
+		bool equal = false;
+
+		if (polarity == negated)
+		{
+			equal = subtree.equals(view, false);
+		}
+		else
+		{
+			// occurrences of different polarity, one is negation of other
+			auto opposite = view.copy();
+			opposite.negation();
+			equal = subtree.equals(ExpressionView(opposite), false);
+		}
+
+		if (!equal)
+		{
+			// different subtrees with variables may still be unifiable
+			return minor.is_ground() ? result_t::Mismatch : result_t::Unknown;
+		}
+	}
+
+	if (j != instance.size())
+	{
+		return result_t::Mismatch;
+	}
+
+	// free variables of consequent are renamed apart from minor premise
+	const auto offset = static_cast<value_t>(minor.max_value());
+	const auto consequent = ExpressionView(schema_, schema_.subtree(0).right()).shifted(offset);
+
+	result = Expression::instantiate(consequent, [&] (Term term) -> Binding
+	{
+		const auto slot = slots_[term.value - offset];
+		if (slot == NO_SLOT)
+		{
+			return {};
+		}
+
+		const auto &[view, negated] = bound[slot];
+		return {view, negated != (term.op == operation_t::Negation)};
+	}, true);
+
+	return result_t::Match;
+}
@@ -0,0 +1,72 @@
+#ifndef SCHEMA_HPP
+#define SCHEMA_HPP
+
+#include <cstdint>
+#include <array>
+#include <vector>
+#include "ast.hpp"
+
+
+/**
+ * @brief Major premise of modus ponens compiled into a matcher
+ *
+ * @note antecedent is turned into preorder instructions once, so a minor
+ * premise is tested in a single pass without lookups, and its subtrees
+ * are bound to dense slots which are read when the consequent is emitted.
+ * Matcher is one-way: it decides only when minor premise has no variable
+ * at function position of antecedent, otherwise caller has to unify
+ */
+class CompiledSchema
+{
+public:
+	enum class result_t : std::uint8_t
+	{
+		Match = 0,
+		Mismatch,
+		Unknown
+	};
+
+	// larger schemas are not compiled, every application answers Unknown
+	static constexpr std::size_t MAX_VARIABLES = 16;
+
+private:
+	enum class opcode_t : std::uint8_t
+	{
+		// node of minor premise must be equal to term
+		Node = 0,
+		// first occurrence of variable, subtree is stored in slot
+		Bind,
+		// repeated occurrence, subtree must be equal to slot
+		Check
+	};
+
+	struct Instruction
+	{
+		opcode_t code;
+		Term term;
+		std::uint8_t slot;
+	};
+
+	Expression schema_;
+	std::vector<Instruction> matcher_;
+
+	// slot of every schema variable by its value
+	std::array<std::uint8_t, MAX_VARIABLES + 1> slots_{};
+	bool compiled_;
+
+public:
+	explicit CompiledSchema(Expression schema);
+
+	inline const Expression &schema() const noexcept { return schema_; }
+
+	/**
+	 * @brief modus ponens of `minor` and compiled schema
+	 *
+	 * @note on Match `result` is set to normalized consequent, which is
+	 * the same expression `modus_ponens` produces, on Mismatch modus ponens
+	 * fails as well; Unknown leaves the pair to `modus_ponens`
+	 */
+	result_t apply(const Expression &minor, Expression &result) const;
+};
+
+#endif // SCHEMA_HPP
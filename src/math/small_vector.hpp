@@ -0,0 +1,180 @@
+#ifndef SMALL_VECTOR_HPP
+#define SMALL_VECTOR_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+
+
+/**
+ * @brief Contiguous array which keeps first N elements inline
+ *
+ * @note only trivially copyable elements are supported,
+ * heap storage is used after inline capacity is exhausted
+ */
+template<typename T, std::size_t N>
+class SmallVector
+{
+	static_assert(std::is_trivially_copyable_v<T>);
+	static_assert(std::is_trivially_destructible_v<T>);
+
+	T *heap_ = nullptr;
+	std::uint32_t size_ = 0;
+	std::uint32_t capacity_ = N;
+	alignas(T) std::byte inline_[N * sizeof(T)];
+
+	inline T *inline_data() noexcept
+	{
+		return std::launder(reinterpret_cast<T *>(inline_));
+	}
+
+	inline const T *inline_data() const noexcept
+	{
+		return std::launder(reinterpret_cast<const T *>(inline_));
+	}
+
+	void grow(std::size_t capacity)
+	{
+		capacity = std::max(capacity, 2 * static_cast<std::size_t>(capacity_));
+
+		T *memory = static_cast<T *>(::operator new(capacity * sizeof(T)));
+		std::memcpy(static_cast<void *>(memory), data(), size_ * sizeof(T));
+
+		release();
+		heap_ = memory;
+		capacity_ = static_cast<std::uint32_t>(capacity);
+	}
+
+	void release() noexcept
+	{
+		if (heap_ != nullptr)
+		{
+			::operator delete(heap_);
+			heap_ = nullptr;
+		}
+
+		capacity_ = N;
+	}
+
+public:
+	SmallVector() noexcept = default;
+
+	SmallVector(const T *first, const T *last)
+	{
+		append(first, last);
+	}
+
+	SmallVector(const SmallVector &other)
+	{
+		append(other.begin(), other.end());
+	}
+
+	SmallVector(SmallVector &&other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	SmallVector &operator=(const SmallVector &other)
+	{
+		if (this != &other)
+		{
+			clear();
+			append(other.begin(), other.end());
+		}
+
+		return *this;
+	}
+
+	SmallVector &operator=(SmallVector &&other) noexcept
+	{
+		if (this == &other)
+		{
+			return *this;
+		}
+
+		release();
+
+		// heap storage is stolen, inline storage is copied
+		if (other.heap_ != nullptr)
+		{
+			heap_ = std::exchange(other.heap_, nullptr);
+			capacity_ = std::exchange(other.capacity_, N);
+		}
+		else
+		{
+			std::memcpy(inline_, other.inline_, other.size_ * sizeof(T));
+		}
+
+		size_ = std::exchange(other.size_, 0);
+		return *this;
+	}
+
+	~SmallVector()
+	{
+		release();
+	}
+
+	inline T *data() noexcept { return heap_ != nullptr ? heap_ : inline_data(); }
+	inline const T *data() const noexcept { return heap_ != nullptr ? heap_ : inline_data(); }
+
+	inline T *begin() noexcept { return data(); }
+	inline T *end() noexcept { return data() + size_; }
+	inline const T *begin() const noexcept { return data(); }
+	inline const T *end() const noexcept { return data() + size_; }
+
+	inline T &operator[](std::size_t idx) noexcept { return data()[idx]; }
+	inline const T &operator[](std::size_t idx) const noexcept { return data()[idx]; }
+	inline T &back() noexcept { return data()[size_ - 1]; }
+
+	inline std::size_t size() const noexcept { return size_; }
+	inline std::size_t capacity() const noexcept { return capacity_; }
+	inline bool empty() const noexcept { return size_ == 0; }
+	inline bool is_inline() const noexcept { return heap_ == nullptr; }
+
+	inline void clear() noexcept { size_ = 0; }
+
+	inline void reserve(std::size_t capacity)
+	{
+		if (capacity > capacity_)
+		{
+			grow(capacity);
+		}
+	}
+
+	template<typename... Args>
+	inline T &emplace_back(Args &&...args)
+	{
+		// arguments may refer to own storage, so value is built before growth
+		const T value(std::forward<Args>(args)...);
+		reserve(size_ + 1);
+
+		T *place = ::new (static_cast<void *>(data() + size_)) T(value);
+		++size_;
+		return *place;
+	}
+
+	inline void push_back(const T &value)
+	{
+		emplace_back(value);
+	}
+
+	// @note range must not belong to this array
+	inline void append(const T *first, const T *last)
+	{
+		const auto count = static_cast<std::size_t>(last - first);
+		if (count == 0)
+		{
+			return;
+		}
+
+		reserve(size_ + count);
+		std::memcpy(static_cast<void *>(data() + size_), first, count * sizeof(T));
+		size_ += static_cast<std::uint32_t>(count);
+	}
+};
+
+#endif // SMALL_VECTOR_HPP
@@ -0,0 +1,133 @@
+#ifndef TRAVERSE_HPP
+#define TRAVERSE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <vector>
+#include <algorithm>
+
+
+/**
+ * @brief what `Expression::traverse` should visit after current node
+ */
+enum class visit_t : std::uint8_t
+{
+	Skip = 0,
+	Left = 1,
+	Right = 2,
+	Both = 3
+};
+
+
+/**
+ * @brief position of `Expression::walk` relative to function node:
+ * before left subtree, between subtrees and after right subtree
+ *
+ * @note leaves are reported only once as `In`
+ */
+enum class order_t : std::uint8_t
+{
+	Pre = 0,
+	In,
+	Post
+};
+
+
+/**
+ * @brief LIFO stack which keeps first N elements inline
+ *
+ * @note overflow storage is allocated only for unusually deep trees
+ */
+template<typename T, std::size_t N = 64>
+class SmallStack
+{
+	std::array<T, N> inline_;
+	std::vector<T> overflow_;
+	std::size_t size_ = 0;
+
+public:
+	inline bool empty() const noexcept { return size_ == 0; }
+	inline std::size_t size() const noexcept { return size_; }
+
+	inline void push(const T &value)
+	{
+		if (size_ < N)
+		{
+			inline_[size_] = value;
+		}
+		else
+		{
+			overflow_.push_back(value);
+		}
+
+		++size_;
+	}
+
+	inline T &top() noexcept
+	{
+		return size_ <= N ? inline_[size_ - 1] : overflow_.back();
+	}
+
+	inline void pop() noexcept
+	{
+		if (size_ > N)
+		{
+			overflow_.pop_back();
+		}
+
+		--size_;
+	}
+};
+
+
+/**
+ * @brief numbers variables by first occurrence: 1, 2, ...
+ *
+ * @note flat array with linear search, formulas rarely have more than
+ * a dozen distinct variables
+ */
+template<typename T, std::size_t N = 32>
+class VariableMap
+{
+	std::array<T, N> inline_;
+	std::vector<T> overflow_;
+	std::size_t size_ = 0;
+
+public:
+	inline std::size_t size() const noexcept { return size_; }
+
+	// number of `value`, new values get next number
+	inline T number(T value)
+	{
+		const auto used = std::min(size_, N);
+		for (std::size_t i = 0; i < used; ++i)
+		{
+			if (inline_[i] == value)
+			{
+				return static_cast<T>(i + 1);
+			}
+		}
+
+		for (std::size_t i = 0; i < overflow_.size(); ++i)
+		{
+			if (overflow_[i] == value)
+			{
+				return static_cast<T>(N + i + 1);
+			}
+		}
+
+		if (size_ < N)
+		{
+			inline_[size_] = value;
+		}
+		else
+		{
+			overflow_.push_back(value);
+		}
+
+		return static_cast<T>(++size_);
+	}
+};
+
+#endif // TRAVERSE_HPP
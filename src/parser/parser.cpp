@@ -107,7 +107,7 @@ Term ExpressionParser::determine_operand(char token)
 		throw std::runtime_error("invalid variable name");
 	}
 
-	return {term_t::Variable, operation_t::Nop, token - 'a' + 1};
+	return {term_t::Variable, operation_t::Nop, static_cast<value_t>(token - 'a' + 1)};
 }
 
 
@@ -19,12 +19,39 @@ std::uint64_t ms_since_epoch()
 
 Solver::Solver(std::vector<Expression> axioms,
 		Expression target,
-		std::uint64_t time_limit_ms
-) 	: known_axioms_()
-	, axioms_(std::move(axioms))
-	, produced_()
+		std::uint64_t time_limit_ms,
+		std::size_t threads
+) 	: pool_(ExpressionPool::shared())
+	, cache_(ModusPonensCache::shared())
+	, known_axioms_()
+	, schemas_()
+	, axioms_(
+		std::make_move_iterator(axioms.begin()),
+		std::make_move_iterator(axioms.end())
+	)
+	, lemma_index_()
+	, antecedent_index_()
+	, consequent_index_()
+	, minors_()
+	, majors_()
+	, generals_()
+	, instances_()
+	, workers_(threads)
+	, candidates_()
+	, arenas_()
+	, generations_{
+		std::pmr::vector<Lemma>(&arenas_[0]),
+		std::pmr::vector<Lemma>(&arenas_[1])
+	}
+	, generation_(0)
 	, targets_()
+	, weight_()
+	, age_ratio_(0)
 	, time_limit_(time_limit_ms)
+	, deadline_(0)
+	, deferred_()
+	, backward_depth_(0)
+	, subgoals_()
 	, ss{}
 	, dump_("conclusions.txt")
 {
@@ -35,51 +62,54 @@ Solver::Solver(std::vector<Expression> axioms,
 
 	targets_.emplace_back(std::move(target));
 	axioms_.reserve(1000);
-	known_axioms_.reserve(10000);
 
 	// produce hack: implication swap rule (a->b) ~ (!b->!a)
-	axioms = {
-		Expression("a>(b>a)"),
-		Expression("(a>(b>c))>((a>b)>(a>c))"),
-		Expression("(!a>!b)>((!a>b)>a)")
+	std::vector<Lemma> rule;
+	for (const auto axiom : {"a>(b>a)", "(a>(b>c))>((a>b)>(a>c))", "(!a>!b)>((!a>b)>a)"})
+	{
+		Expression expression(axiom);
+		const auto id = pool_.intern(expression);
+		rule.emplace_back(std::move(expression), id);
+	}
+
+	// steps are memoized, so next solvers of the process don't repeat them
+	constexpr std::pair<std::size_t, std::size_t> steps[] = {
+		{0, 0}, {1, 0}, {3, 1}, {4, 1}, {2, 5}, {6, 6}, {7, 8}, {3, 9}
 	};
 
-	axioms.emplace_back(modus_ponens(axioms[0], axioms[0]));
-	axioms.emplace_back(modus_ponens(axioms[1], axioms[0]));
-	axioms.emplace_back(modus_ponens(axioms[3], axioms[1]));
-	axioms.emplace_back(modus_ponens(axioms[4], axioms[1]));
-	axioms.emplace_back(modus_ponens(axioms[2], axioms[5]));
-	axioms.emplace_back(modus_ponens(axioms[6], axioms[6]));
-	axioms.emplace_back(modus_ponens(axioms[7], axioms[8]));
-	axioms.emplace_back(modus_ponens(axioms[3], axioms[9]));
-
-	dump_ << axioms[3] << ' ' << "mp" << ' ' << axioms[0] << ' ' << axioms[0] << '\n';
-	dump_ << axioms[4] << ' ' << "mp" << ' ' << axioms[1] << ' ' << axioms[0] << '\n';
-	dump_ << axioms[5] << ' ' << "mp" << ' ' << axioms[3] << ' ' << axioms[1] << '\n';
-	dump_ << axioms[6] << ' ' << "mp" << ' ' << axioms[4] << ' ' << axioms[1] << '\n';
-	dump_ << axioms[7] << ' ' << "mp" << ' ' << axioms[2] << ' ' << axioms[5] << '\n';
-	dump_ << axioms[8] << ' ' << "mp" << ' ' << axioms[6] << ' ' << axioms[5] << '\n';
-	dump_ << axioms[9] << ' ' << "mp" << ' ' << axioms[7] << ' ' << axioms[8] << '\n';
-	dump_ << axioms[10] << ' ' << "mp" << ' ' << axioms[3] << ' ' << axioms[9] << '\n';
-}
+	for (const auto &[minor, major] : steps)
+	{
+		ExpressionPool::id_t id;
+		auto expression = combine(rule[minor], rule[major], id);
+		id = remember(rule[minor], rule[major], expression, id);
 
+		dump_ << expression << ' ' << "mp" << ' '
+		<< rule[minor].expression << ' ' << rule[major].expression << '\n';
 
-bool Solver::is_target_proved_by(const Expression &expression) const
-{
-	if (expression.empty())
-	{
-		return false;
+		rule.emplace_back(std::move(expression), id);
 	}
+}
 
-	for (const auto &target : targets_)
+
+std::size_t Solver::proved_target(const Expression &expression) const
+{
+	// general lemma proves every target which is its instance,
+	// variables are replaced with target subformulas later
+	for (std::size_t i = 0; i < targets_.size(); ++i)
 	{
-		if (is_equal(target, expression))
+		if (is_instance(expression, targets_[i]))
 		{
-			return true;
+			return i;
 		}
 	}
 
-	return false;
+	return INVALID_INDEX;
+}
+
+
+bool Solver::is_target_proved_by(const Expression &expression) const
+{
+	return proved_target(expression) != INVALID_INDEX;
 }
 
 
@@ -112,99 +142,671 @@ bool Solver::deduction_theorem_decomposition(Expression expression)
 
 void Solver::produce(std::size_t max_len)
 {
-	if (produced_.empty())
+	if (produced().empty())
 	{
 		return;
 	}
 
-	std::vector<Expression> newly_produced;
-	newly_produced.reserve(2 * produced_.size());
+	release_generation(generation_ + 1);
+	auto &newly_produced = generations_[(generation_ + 1) % 2];
+	newly_produced.reserve(2 * produced().size());
 
-	Expression expr;
-	std::string repr;
-
-	for (auto &expression : produced_)
+	std::size_t next = 0;
+	for (; next < produced().size(); ++next)
 	{
-		if (ms_since_epoch() > time_limit_)
+		if (ms_since_epoch() > deadline_)
 		{
 			break;
 		}
 
-		if (expression.size() > max_len)
+		if (promote(produced()[next], max_len, newly_produced))
 		{
-			continue;
+			return;
 		}
+	}
+
+	if (ms_since_epoch() > time_limit_)
+	{
+		return;
+	}
+
+	// lemmas left at the end of level are given at the next one
+	for (; next < produced().size(); ++next)
+	{
+		newly_produced.push_back(produced()[next]);
+	}
+
+	std::ranges::sort(newly_produced, [] (const auto &lhs, const auto &rhs) {
+		return lhs.expression.size() < rhs.expression.size();
+	});
+
+	++generation_;
+}
+
+
+void Solver::defer(
+	Expression &expression,
+	ExpressionPool::id_t id,
+	std::size_t minor,
+	std::size_t major,
+	std::size_t max_len
+)
+{
+	if (expression.size() <= max_len ||
+		expression.size() > MAX_BOUND ||
+		deferred_.size() >= MAX_DEFERRED)
+	{
+		return;
+	}
+
+	deferred_.push_back({std::move(expression), id, minor, major});
+}
 
-		// add expression
-		expression.normalize();
-		axioms_.push_back(expression);
 
-		if (is_target_proved_by(axioms_.back()))
+void Solver::raise_bound(std::size_t max_len)
+{
+	// results are admitted in the order they were produced,
+	// the ones which are still too long wait for the next level
+	std::size_t kept = 0;
+	for (auto &item : deferred_)
+	{
+		if (item.expression.size() > max_len)
 		{
-			return;
+			if (&deferred_[kept] != &item)
+			{
+				deferred_[kept] = std::move(item);
+			}
+
+			++kept;
+			continue;
 		}
 
-		// produce new expressions
-		for (std::size_t j = 0; j < axioms_.size(); ++j)
+		if (!is_new(item.expression, max_len))
 		{
-			expr = std::move(modus_ponens(axioms_[j], axioms_.back()));
+			continue;
+		}
 
-			if (!is_good_expression(expr, max_len) ||
-				known_axioms_.contains(expr.to_string()))
-			{
-				continue;
-			}
+		const auto &minor = axioms_[item.minor];
+		const auto &major = axioms_[item.major];
+		const auto id = remember(minor, major, item.expression, item.id);
+
+		dump_ << item.expression << ' ' << "mp" << ' '
+		<< minor.expression << ' ' << major.expression << '\n';
+
+		produced().emplace_back(std::move(item.expression), id);
+	}
+
+	deferred_.erase(deferred_.begin() + static_cast<std::ptrdiff_t>(kept), deferred_.end());
+
+	std::ranges::sort(produced(), [] (const auto &lhs, const auto &rhs) {
+		return lhs.expression.size() < rhs.expression.size();
+	});
+}
+
+
+void Solver::given_clause(std::size_t max_len)
+{
+	// passive lemmas are numbered by age, both orders refer to these numbers
+	using entry_t = std::pair<double, std::size_t>;
+	std::priority_queue<entry_t, std::vector<entry_t>, std::greater<>> lightest;
+	std::vector<Lemma> passive;
+	std::vector<bool> given;
+	std::size_t oldest = 0;
+
+	const auto add_passive = [&] (Lemma &lemma)
+	{
+		lightest.emplace(weight_(lemma.expression, targets_), passive.size());
+		passive.push_back(std::move(lemma));
+		given.push_back(false);
+	};
 
-			newly_produced.emplace_back(expr);
-			known_axioms_.insert(newly_produced.back().to_string());
+	for (auto &lemma : produced())
+	{
+		add_passive(lemma);
+	}
+	release_generation(generation_);
 
-			dump_ << newly_produced.back() << ' ' << "mp" << ' '
-			<< axioms_[j] << ' ' << axioms_.back() << '\n';
+	std::pmr::vector<Lemma> results;
+	for (std::size_t pick = 1; ms_since_epoch() < time_limit_; ++pick)
+	{
+		auto next = INVALID_INDEX;
 
-			if (is_target_proved_by(newly_produced.back()))
+		if (age_ratio_ != 0 && pick % age_ratio_ == 0)
+		{
+			while (oldest < passive.size() && given[oldest])
 			{
-				axioms_.push_back(newly_produced.back());
-				return;
+				++oldest;
 			}
 
-			if (j + 1 == axioms_.size())
+			if (oldest < passive.size())
 			{
-				break;
+				next = oldest;
 			}
+		}
 
-			// inverse order
-			expr = std::move(modus_ponens(axioms_.back(), axioms_[j]));
-
-			if (!is_good_expression(expr, max_len) ||
-				known_axioms_.contains(expr.to_string()))
+		if (next == INVALID_INDEX)
+		{
+			while (!lightest.empty() && given[lightest.top().second])
 			{
-				continue;
+				lightest.pop();
 			}
 
-			newly_produced.emplace_back(expr);
-			known_axioms_.insert(newly_produced.back().to_string());
-
-			dump_ << newly_produced.back() << ' ' << "mp" << ' '
-			<< axioms_.back() << ' ' << axioms_[j] << '\n';
-
-			if (is_target_proved_by(newly_produced.back()))
+			if (lightest.empty())
 			{
-				axioms_.push_back(newly_produced.back());
 				return;
 			}
+
+			next = lightest.top().second;
+			lightest.pop();
+		}
+
+		// given lemma is copied to `axioms_`, passive copy is not needed
+		given[next] = true;
+		const auto lemma = std::move(passive[next]);
+
+		results.clear();
+		if (promote(lemma, max_len, results))
+		{
+			return;
+		}
+
+		for (auto &result : results)
+		{
+			add_passive(result);
+		}
+	}
+}
+
+
+bool Solver::backward(std::size_t max_len)
+{
+	// new lemmas may prove what failed before
+	std::erase_if(subgoals_, [] (const auto &item) {
+		return item.second.status != Subgoal::status_t::Proved;
+	});
+
+	// the last target is the smallest one after deduction theorem
+	for (auto i = targets_.size(); i-- > 0;)
+	{
+		if (prove_backward(targets_[i], backward_depth_, max_len) != INVALID_INDEX)
+		{
+			return true;
 		}
 	}
 
-	if (ms_since_epoch() > time_limit_)
+	return false;
+}
+
+
+std::size_t Solver::prove_backward(
+	const Expression &goal,
+	std::size_t depth,
+	std::size_t max_len
+)
+{
+	// goals are ground, so equal goals share pool id;
+	// references to elements of unordered map survive insertions
+	auto &subgoal = subgoals_[pool_.intern(goal)];
+
+	switch (subgoal.status)
+	{
+	case Subgoal::status_t::Proved:
+		return subgoal.position;
+	case Subgoal::status_t::Open:
+		return INVALID_INDEX;
+	case Subgoal::status_t::Failed:
+		if (subgoal.depth >= depth)
+		{
+			return INVALID_INDEX;
+		}
+		break;
+	case Subgoal::status_t::Unknown:
+		break;
+	}
+
+	// backward search meets forward one
+	generals_.clear();
+	lemma_index_.generalizations(goal, generals_);
+
+	for (const auto position : generals_)
 	{
+		if (is_instance(axioms_[position].expression, goal))
+		{
+			subgoal.status = Subgoal::status_t::Proved;
+			subgoal.position = position;
+			return position;
+		}
+	}
+
+	if (depth == 0 || ms_since_epoch() > deadline_)
+	{
+		subgoal.status = Subgoal::status_t::Failed;
+		subgoal.depth = 0;
+		return INVALID_INDEX;
+	}
+
+	// goal is ground, so consequent which unifies with it is its generalization
+	std::vector<DiscriminationTree::value_type> majors;
+	consequent_index_.generalizations(goal, majors);
+	std::ranges::sort(majors);
+
+	subgoal.status = Subgoal::status_t::Open;
+
+	for (const auto major : majors)
+	{
+		// `axioms_` grows while subgoals are proved, so lemmas are accessed by position
+		auto antecedent = instantiate_match(
+			ExpressionView(axioms_[major].expression, axioms_[major].expression.subtree(0).right()),
+			goal,
+			ExpressionView(axioms_[major].expression, axioms_[major].expression.subtree(0).left())
+		);
+
+		// variables absent in consequent would make subgoal a schema, those are skipped
+		if (antecedent.empty() || !antecedent.is_ground() ||
+			!is_good_expression(antecedent, max_len))
+		{
+			continue;
+		}
+
+		const auto minor = prove_backward(antecedent, depth - 1, max_len);
+		if (minor == INVALID_INDEX)
+		{
+			continue;
+		}
+
+		// replayed step is at least as general as the goal,
+		// unless unifier rejects it, then next lemma is tried
+		ExpressionPool::id_t id;
+		auto result = combine(axioms_[minor], axioms_[major], id);
+		if (result.empty() || !is_instance(result, goal))
+		{
+			continue;
+		}
+
+		id = remember(axioms_[minor], axioms_[major], result, id);
+		known_axioms_.insert(result.canonical_fingerprint());
+
+		dump_ << result << ' ' << "mp" << ' '
+		<< axioms_[minor].expression << ' ' << axioms_[major].expression << '\n';
+
+		add_lemma(Lemma(std::move(result), id));
+
+		subgoal.status = Subgoal::status_t::Proved;
+		subgoal.position = axioms_.size() - 1;
+		return subgoal.position;
+	}
+
+	subgoal.status = Subgoal::status_t::Failed;
+	subgoal.depth = depth;
+	return INVALID_INDEX;
+}
+
+
+bool Solver::keeps_reordered_duplicate(
+	const Expression &duplicate,
+	const std::vector<Expression> &targets
+)
+{
+	// twin which proves a target as well would have ended the search,
+	// so only a reordered duplicate gets here with a proof
+	return std::ranges::any_of(targets, [&] (const auto &target) {
+		return is_instance(duplicate, target);
+	});
+}
+
+
+bool Solver::is_new(const Expression &expression, std::size_t max_len)
+{
+	// fingerprint ignores variable naming and order of commutative operands,
+	// so duplicates are rejected cheaply; instances of known lemmas add
+	// nothing new to the search, target instances are detected on their general form
+	if (!is_good_expression(expression, max_len))
+	{
+		return false;
+	}
+
+	if (!known_axioms_.insert(expression.canonical_fingerprint()) &&
+		!keeps_reordered_duplicate(expression, targets_))
+	{
+		return false;
+	}
+
+	return !is_subsumed(expression);
+}
+
+
+bool Solver::promote(
+	const Lemma &lemma,
+	std::size_t max_len,
+	std::pmr::vector<Lemma> &produced
+)
+{
+	if (lemma.expression.size() > max_len)
+	{
+		return false;
+	}
+
+	// more general lemma may have arrived after this one was produced
+	if (is_subsumed(lemma.expression))
+	{
+		return false;
+	}
+
+	// add expression
+	add_lemma(lemma);
+
+	if (is_target_proved_by(axioms_.back().expression))
+	{
+		return true;
+	}
+
+	// only lemmas which may unify with the new one are tried,
+	// in the same order as `axioms_` are stored; inverse order is
+	// tried only after a new forward result, so it needs no full scan
+	const auto &lemma_expression = axioms_.back().expression;
+	minors_.clear();
+	majors_.clear();
+
+	if (lemma_expression[0].type == term_t::Function &&
+		lemma_expression[0].op == operation_t::Implication)
+	{
+		lemma_index_.retrieve(
+			ExpressionView(lemma_expression, lemma_expression.subtree(0).left()),
+			minors_
+		);
+		antecedent_index_.retrieve(lemma_expression, majors_);
+	}
+
+	std::ranges::sort(minors_);
+	std::ranges::sort(majors_);
+
+	prepare_candidates();
+
+	Expression expr;
+	ExpressionPool::id_t id;
+
+	// produce new expressions
+	for (std::size_t k = 0; k < minors_.size(); ++k)
+	{
+		const auto j = minors_[k];
+		auto &candidate = candidates_[k];
+
+		if (candidate.ready)
+		{
+			expr = std::move(candidate.forward);
+			id = candidate.forward_id;
+		}
+		else
+		{
+			expr = combine(axioms_[j], axioms_.back(), id);
+		}
+
+		if (!is_new(expr, max_len))
+		{
+			defer(expr, id, j, axioms_.size() - 1, max_len);
+			continue;
+		}
+
+		id = remember(axioms_[j], axioms_.back(), expr, id);
+		produced.emplace_back(std::move(expr), id);
+
+		dump_ << produced.back().expression << ' ' << "mp" << ' '
+		<< axioms_[j].expression << ' ' << axioms_.back().expression << '\n';
+
+		if (is_target_proved_by(produced.back().expression))
+		{
+			add_lemma(produced.back());
+			return true;
+		}
+
+		if (j + 1 == axioms_.size())
+		{
+			break;
+		}
+
+		// inverse order
+		if (!std::ranges::binary_search(majors_, j))
+		{
+			continue;
+		}
+
+		if (candidate.ready)
+		{
+			expr = std::move(candidate.inverse);
+			id = candidate.inverse_id;
+		}
+		else
+		{
+			expr = combine(axioms_.back(), axioms_[j], id);
+		}
+
+		if (!is_new(expr, max_len))
+		{
+			defer(expr, id, axioms_.size() - 1, j, max_len);
+			continue;
+		}
+
+		id = remember(axioms_.back(), axioms_[j], expr, id);
+		produced.emplace_back(std::move(expr), id);
+
+		dump_ << produced.back().expression << ' ' << "mp" << ' '
+		<< axioms_.back().expression << ' ' << axioms_[j].expression << '\n';
+
+		if (is_target_proved_by(produced.back().expression))
+		{
+			add_lemma(produced.back());
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+void Solver::add_lemma(const Lemma &lemma)
+{
+	const auto position = static_cast<DiscriminationTree::value_type>(axioms_.size());
+	axioms_.push_back(lemma);
+
+	const auto &expression = axioms_.back().expression;
+
+	// backward subsumption: more specific lemmas are not combined anymore
+	instances_.clear();
+	lemma_index_.instances(expression, instances_);
+
+	for (const auto other : instances_)
+	{
+		if (is_instance(expression, axioms_[other].expression))
+		{
+			retire(other);
+		}
+	}
+
+	lemma_index_.insert(expression, position);
+
+	if (expression[0].type == term_t::Function &&
+		expression[0].op == operation_t::Implication)
+	{
+		antecedent_index_.insert(
+			ExpressionView(expression, expression.subtree(0).left()),
+			position
+		);
+
+		if (backward_depth_ != 0)
+		{
+			consequent_index_.insert(
+				ExpressionView(expression, expression.subtree(0).right()),
+				position
+			);
+		}
+	}
+}
+
+
+void Solver::retire(std::size_t position)
+{
+	auto &lemma = axioms_[position];
+	const auto value = static_cast<DiscriminationTree::value_type>(position);
+
+	lemma.retired = true;
+	lemma_index_.erase(lemma.expression, value);
+
+	if (lemma.expression[0].type == term_t::Function &&
+		lemma.expression[0].op == operation_t::Implication)
+	{
+		antecedent_index_.erase(
+			ExpressionView(lemma.expression, lemma.expression.subtree(0).left()),
+			value
+		);
+
+		if (backward_depth_ != 0)
+		{
+			consequent_index_.erase(
+				ExpressionView(lemma.expression, lemma.expression.subtree(0).right()),
+				value
+			);
+		}
+	}
+}
+
+
+void Solver::prepare_candidates()
+{
+	candidates_.resize(minors_.size());
+
+	if (workers_.size() == 1 || minors_.size() < PARALLEL_PAIRS)
+	{
+		for (auto &candidate : candidates_)
+		{
+			candidate.ready = false;
+		}
+
 		return;
 	}
 
-	std::ranges::sort(newly_produced, [] (const auto &lhs, const auto &rhs) {
-		return lhs.size() < rhs.size();
+	// inverse order is combined speculatively, it is used only when
+	// forward result is accepted; pool is read but never written here
+	workers_.parallel_for(minors_.size(), [&] (std::size_t k)
+	{
+		const auto j = minors_[k];
+		auto &candidate = candidates_[k];
+
+		candidate.forward = combine(axioms_[j], axioms_.back(), candidate.forward_id);
+		candidate.inverse = {};
+
+		if (j + 1 != axioms_.size() && std::ranges::binary_search(majors_, j))
+		{
+			candidate.inverse = combine(axioms_.back(), axioms_[j], candidate.inverse_id);
+		}
+
+		candidate.ready = true;
 	});
+}
 
-	produced_ = std::move(newly_produced);
+
+Expression Solver::combine(
+	const Lemma &minor,
+	const Lemma &major,
+	ExpressionPool::id_t &id
+)
+{
+	// equal formulas share pool id, so ground pair is decided by ids alone
+	if (minor.expression.is_ground() && major.expression.is_ground())
+	{
+		const auto &entry = pool_[major.id];
+		if (entry.term.op != operation_t::Implication || entry.left != minor.id)
+		{
+			return {};
+		}
+
+		id = entry.right;
+		return pool_.expression(id);
+	}
+
+	// minor premise which is an instance of antecedent needs no unification
+	if (const auto schema = schemas_.find(major.id); schema != schemas_.end())
+	{
+		Expression result;
+		switch (schema->second.apply(minor.expression, result))
+		{
+		case CompiledSchema::result_t::Match:
+			id = ExpressionPool::INVALID_ID;
+			return result;
+		case CompiledSchema::result_t::Mismatch:
+			return {};
+		case CompiledSchema::result_t::Unknown:
+			break;
+		}
+	}
+
+	if (cache_.find(minor.id, major.id, id))
+	{
+		return id == ModusPonensCache::FAILED ? Expression{} : pool_.expression(id);
+	}
+
+	auto expression = modus_ponens(minor.expression, major.expression);
+
+	// failures are cheap to keep, results are interned only when kept
+	if (expression.empty())
+	{
+		cache_.insert(minor.id, major.id, ModusPonensCache::FAILED);
+	}
+
+	id = ExpressionPool::INVALID_ID;
+	return expression;
+}
+
+
+ExpressionPool::id_t Solver::remember(
+	const Lemma &minor,
+	const Lemma &major,
+	const Expression &expression,
+	ExpressionPool::id_t id
+)
+{
+	if (id != ExpressionPool::INVALID_ID)
+	{
+		return id;
+	}
+
+	id = pool_.intern(expression);
+	cache_.insert(minor.id, major.id, id);
+
+	return id;
+}
+
+
+bool Solver::is_subsumed(const Expression &expression)
+{
+	generals_.clear();
+	lemma_index_.generalizations(expression, generals_);
+
+	return std::ranges::any_of(generals_, [&] (const auto position) {
+		return is_instance(axioms_[position].expression, expression);
+	});
+}
+
+
+void Solver::release_generation(std::size_t generation)
+{
+	const auto idx = generation % 2;
+
+	// vector must give its storage back before arena is released
+	std::pmr::vector<Lemma>(&arenas_[idx]).swap(generations_[idx]);
+	arenas_[idx].release();
+}
+
+
+void Solver::set_weight(weight_t weight, std::size_t age_ratio)
+{
+	weight_ = std::move(weight);
+	age_ratio_ = age_ratio;
+}
+
+
+void Solver::set_backward(std::size_t depth)
+{
+	backward_depth_ = depth;
 }
 
 
@@ -212,33 +814,54 @@ void Solver::solve()
 {
 	ss.clear();
 
-	// we will produce at most m operations in one expression
-	// if more operations are required, increase it
-	std::size_t len = 20;
+	// memo refers to pool ids, so shared pool is bounded by dropping both;
+	// ids are used only from here on, so nothing of this run is lost
+	if (pool_.size() > MAX_POOL_ENTRIES)
+	{
+		cache_.clear();
+		pool_.clear();
+	}
 
 	// simplify target if it's possible
 	while (deduction_theorem_decomposition(targets_.back()))
 	{
 		auto &prev = targets_[targets_.size() - 2];
 		auto &curr = targets_.back();
-		auto &axiom = axioms_.back();
+		auto &axiom = axioms_.back().expression;
 
 		ss << "deduction theorem: " << "Γ ⊢ " << prev << " <=> "
 		<< "Γ U {" << axiom << "} ⊢ " << curr << '\n';
 	}
 
 	// write all axioms to produced array
-	for (std::size_t i = 0; i < axioms_.size(); ++i)
+	for (auto &axiom : axioms_)
 	{
-		axioms_[i].normalize();
-		produced_.push_back(axioms_[i]);
-		dump_ << axioms_[i] << ' ' << "axiom" << '\n';
+		axiom.expression.normalize();
+		axiom.id = pool_.intern(axiom.expression);
+		produced().push_back(axiom);
+		dump_ << axiom.expression << ' ' << "axiom" << '\n';
 	}
 
 	// isr rule
-	produced_.emplace_back(Expression("(!a>!b)>(b>a)"));
+	Expression isr("(!a>!b)>(b>a)");
+	isr.normalize();
+	produced().emplace_back(isr, pool_.intern(isr));
+
+	// initial schemas never change, so they are compiled once
+	for (const auto &lemma : produced())
+	{
+		if (!lemma.expression.is_ground())
+		{
+			schemas_.try_emplace(lemma.id, lemma.expression);
+		}
+	}
 	axioms_.clear();
+	lemma_index_.clear();
+	antecedent_index_.clear();
+	consequent_index_.clear();
 	known_axioms_.clear();
+	subgoals_.clear();
+	deferred_.clear();
 
 	// calculating the stopping criterion
 	const auto time = ms_since_epoch();
@@ -247,49 +870,82 @@ void Solver::solve()
 		std::numeric_limits<std::uint64_t>::max() :
 		time + time_limit_;
 
-	while (ms_since_epoch() < time_limit_)
+	if (weight_)
 	{
-		produce(len);
-
-		if (is_target_proved_by(axioms_.back()))
-		{
-			break;
-		}
+		deadline_ = time_limit_;
+		given_clause(MAX_BOUND);
 	}
 
-	if (std::ranges::none_of(axioms_, [&] (const auto &expression) {
-		return is_target_proved_by(expression);
-	}))
+	// iterative deepening: size bound starts near the size of the goal,
+	// but admits every initial lemma, and is raised when level saturates
+	// or spends its share of time; lemmas of earlier levels are kept
+	auto bound = targets_.front().size() + BOUND_STEP;
+	for (const auto &lemma : produced())
 	{
-		ss << "No proof was found in the time allotted\n";
-		return;
+		bound = std::max(bound, lemma.expression.size());
 	}
+	bound = std::clamp(bound, MIN_BOUND, MAX_BOUND);
 
-	// find which target was proved
-	Expression proof;
-	Expression target_proved;
+	const auto start_level = [&] ()
+	{
+		const auto now = ms_since_epoch();
+		const auto levels = (MAX_BOUND - bound) / BOUND_STEP + 1;
+		deadline_ = now >= time_limit_ ? time_limit_ : now + (time_limit_ - now) / levels;
+	};
+	start_level();
 
-	for (const auto &axiom : axioms_)
+	while (!weight_ && ms_since_epoch() < time_limit_)
 	{
-		if (!proof.empty())
+		produce(bound);
+
+		if (!axioms_.empty() && is_target_proved_by(axioms_.back().expression))
 		{
 			break;
 		}
 
-		for (const auto &target : targets_)
+		if (backward_depth_ != 0 && backward(bound))
+		{
+			break;
+		}
+
+		if (!produced().empty() && ms_since_epoch() <= deadline_)
+		{
+			continue;
+		}
+
+		if (bound == MAX_BOUND)
 		{
-			if (is_equal(target, axiom))
+			// whole space of the largest bound is exhausted
+			if (produced().empty())
 			{
-				proof = axiom;
-				target_proved = target;
 				break;
 			}
+
+			deadline_ = time_limit_;
+			continue;
 		}
+
+		bound = std::min(bound + BOUND_STEP, MAX_BOUND);
+		start_level();
+		raise_bound(bound);
+	}
+
+	// find which target was proved
+	const auto proof = std::ranges::find_if(axioms_, [&] (const auto &axiom) {
+		return is_target_proved_by(axiom.expression);
+	});
+
+	if (proof == axioms_.end())
+	{
+		ss << "No proof was found in the time allotted\n";
+		return;
 	}
 
+	const auto &target_proved = targets_[proved_target(proof->expression)];
+
 	// build proof chain
 	dump_.flush();
-	build_thought_chain(proof, target_proved);
+	build_thought_chain(proof->expression, target_proved);
 }
 
 
@@ -409,18 +1065,26 @@ void Solver::build_thought_chain(Expression proof, Expression proved_target)
 	}
 
 	// change variables if required
-	std::unordered_map<value_t, Expression> substitution;
-	unification(proved_target, proof, substitution);
+	substitution_t substitution;
+	matching(proof, proved_target, substitution);
 
 	if (substitution.empty())
 	{
 		return;
 	}
 
+	// bucket order depends on allocator, so variables are listed from last to first
+	std::vector<value_t> variables;
+	for (const auto &entry : substitution)
+	{
+		variables.push_back(entry.first);
+	}
+	std::ranges::sort(variables, std::greater<>{});
+
 	ss << "change variables: " << proof << "\n";
-	for (auto &[v, s] : substitution)
+	for (const auto v : variables)
 	{
-		ss << (char)(v + 'A' - 1) << " -> " << s << '\n';
+		ss << (char)(v + 'A' - 1) << " -> " << substitution.at(v) << '\n';
 	}
 
 	ss << "proved: " << proved_target << '\n';
@@ -431,3 +1095,15 @@ std::string Solver::thought_chain() const
 {
 	return ss.str();
 }
+
+
+ModusPonensCache::Statistics Solver::cache_statistics() const noexcept
+{
+	return cache_.statistics();
+}
+
+
+std::size_t Solver::dedup_overflows() const noexcept
+{
+	return known_axioms_.overflows();
+}
@@ -9,7 +9,16 @@
 #include <queue>
 #include <unordered_set>
 #include <unordered_map>
+#include <array>
+#include <memory_resource>
 #include "../math/ast.hpp"
+#include "../math/pool.hpp"
+#include "../math/index.hpp"
+#include "../math/cache.hpp"
+#include "../math/schema.hpp"
+#include "../math/fingerprint_set.hpp"
+#include "thread_pool.hpp"
+#include "weight.hpp"
 
 
 struct Node
@@ -31,17 +40,138 @@ struct Node
 };
 
 
+struct Lemma
+{
+	Expression expression;
+	ExpressionPool::id_t id;
+
+	// lemma is an instance of a more general one and takes no part in search,
+	// it is kept for proof reconstruction
+	bool retired;
+
+	Lemma(Expression expression = {}, ExpressionPool::id_t id = ExpressionPool::INVALID_ID)
+		: expression(std::move(expression))
+		, id(id)
+		, retired(false)
+	{}
+};
+
+
 class Solver
 {
-	std::unordered_set<std::string> known_axioms_;
+	// outcomes of both orders of one pair, computed ahead of acceptance
+	struct Candidate
+	{
+		Expression forward;
+		Expression inverse;
+		ExpressionPool::id_t forward_id;
+		ExpressionPool::id_t inverse_id;
+		bool ready = false;
+	};
+
+	// fewer pairs are cheaper to combine than to hand over to threads
+	static constexpr std::size_t PARALLEL_PAIRS = 32;
+
+	// result longer than current size bound, reconsidered when bound is raised
+	struct Deferred
+	{
+		Expression expression;
+		ExpressionPool::id_t id;
+		std::size_t minor;
+		std::size_t major;
+	};
+
+	// size bounds of iterative deepening, every level gets an equal share
+	// of the time left; beyond MAX_DEFERRED long results are dropped
+	static constexpr std::size_t MIN_BOUND = 12;
+	static constexpr std::size_t MAX_BOUND = 32;
+	static constexpr std::size_t BOUND_STEP = 4;
+	static constexpr std::size_t MAX_DEFERRED = 1 << 18;
+
+	static_assert(MAX_BOUND <= Expression::INLINE_NODES, "lemmas must fit into inline buffer");
+
+	// shared pool larger than this is dropped together with the memo before a run
+	static constexpr std::size_t MAX_POOL_ENTRIES = 1 << 21;
+
+	// subgoal of backward chaining, tabled by pool id of its formula
+	struct Subgoal
+	{
+		enum class status_t : std::uint8_t
+		{
+			Unknown = 0,
+			Open,
+			Proved,
+			Failed
+		};
+
+		status_t status = status_t::Unknown;
+
+		// position of proving lemma in `axioms_` or depth of the failed search
+		std::size_t position = INVALID_INDEX;
+		std::size_t depth = 0;
+	};
+
+	// every derived expression is interned here, pool and memo of
+	// modus ponens outcomes are shared by all solvers of the process
+	ExpressionPool &pool_;
+	ModusPonensCache &cache_;
+
+	// fingerprints of accepted lemmas, safe for concurrent inserts
+	FingerprintSet known_axioms_;
+
+	// initial schemas by pool id, modus ponens with them as major premise
+	// goes through compiled matcher before the unifier
+	std::unordered_map<ExpressionPool::id_t, CompiledSchema> schemas_;
 
 	// map hash value of expression to hash_values of dependent expressions
-	std::vector<Expression> axioms_;
-	std::vector<Expression> produced_;
+	std::vector<Lemma> axioms_;
+
+	// positions in `axioms_` of every lemma and of antecedents of implications,
+	// partners for modus ponens are retrieved from them instead of full scan
+	DiscriminationTree lemma_index_;
+	DiscriminationTree antecedent_index_;
+
+	// consequents of implications, kept only in backward mode
+	DiscriminationTree consequent_index_;
+	std::vector<DiscriminationTree::value_type> minors_;
+	std::vector<DiscriminationTree::value_type> majors_;
+	std::vector<DiscriminationTree::value_type> generals_;
+	std::vector<DiscriminationTree::value_type> instances_;
+
+	// pairs of new lemma are combined by all threads, candidates are then
+	// accepted in order of `minors_` by solving thread, so result
+	// doesn't depend on number of threads
+	WorkStealingPool workers_;
+	std::vector<Candidate> candidates_;
+
+	// lemmas of current and next generation are allocated from two arenas,
+	// consumed generation is released at once; survivors are copied to `axioms_`
+	std::array<std::pmr::monotonic_buffer_resource, 2> arenas_;
+	std::array<std::pmr::vector<Lemma>, 2> generations_;
+	std::size_t generation_;
+
+	// lemmas of current generation
+	inline std::pmr::vector<Lemma> &produced() { return generations_[generation_ % 2]; }
 
 	std::vector<Expression> targets_;
+
+	// given-clause search is used when weight is set, otherwise generations
+	// are processed breadth-first; every `age_ratio_`-th given lemma
+	// is the oldest passive one, so heavy lemmas are not starved
+	weight_t weight_;
+	std::size_t age_ratio_;
+
 	std::uint64_t time_limit_;
 
+	// end of current level of iterative deepening, never after `time_limit_`
+	std::uint64_t deadline_;
+	std::vector<Deferred> deferred_;
+
+	// depth of backward chaining after every generation, 0 turns it off;
+	// proved subgoals are kept, failed ones are retried next round
+	std::size_t backward_depth_;
+	std::unordered_map<ExpressionPool::id_t, Subgoal> subgoals_;
+
 	// stream to store thought chain
 	std::stringstream ss;
 	std::ofstream dump_;
@@ -52,7 +182,75 @@ class Solver
 	// iteration function
 	void produce(std::size_t max_len);
 
-	// is any target if follows from expression?
+	// keep result rejected by size bound `max_len` for later levels
+	void defer(
+		Expression &expression,
+		ExpressionPool::id_t id,
+		std::size_t minor,
+		std::size_t major,
+		std::size_t max_len
+	);
+
+	// admit deferred results which fit into `max_len` to current generation
+	void raise_bound(std::size_t max_len);
+
+	// best-first main loop, the lightest passive lemma is given next
+	void given_clause(std::size_t max_len);
+
+	// round of backward chaining from every target, returns `true` if target is proved
+	bool backward(std::size_t max_len);
+
+	/**
+	 * @brief prove ground `goal` from lemmas `X>C` whose consequent `C` matches it,
+	 * subgoal `X` is proved the same way or met by some forward lemma
+	 *
+	 * @note every step is replayed by real modus ponens and its result is
+	 * added to `axioms_`, so proof chain is built as for forward lemmas
+	 *
+	 * @return Returns position of lemma which `goal` is an instance of,
+	 * INVALID_INDEX if it was not found within `depth` steps.
+	 */
+	std::size_t prove_backward(const Expression &goal, std::size_t depth, std::size_t max_len);
+
+	// is expression short enough, not known and not subsumed?
+	bool is_new(const Expression &expression, std::size_t max_len);
+
+	// add lemma to `axioms_` and combine it with its partners, accepted
+	// results are appended to `produced`; returns `true` if target is proved
+	bool promote(const Lemma &lemma, std::size_t max_len, std::pmr::vector<Lemma> &produced);
+
+	// combine pairs of `minors_` with the last lemma ahead of acceptance
+	void prepare_candidates();
+
+	// modus ponens through the memo, `id` is set to pool id of result
+	// or to INVALID_ID if the result was computed and is not interned yet
+	Expression combine(const Lemma &minor, const Lemma &major, ExpressionPool::id_t &id);
+
+	// intern kept result of `combine` and memoize it, returns its pool id
+	ExpressionPool::id_t remember(
+		const Lemma &minor,
+		const Lemma &major,
+		const Expression &expression,
+		ExpressionPool::id_t id
+	);
+
+	// append lemma to `axioms_` and to partner indices,
+	// lemmas which are its instances are retired
+	void add_lemma(const Lemma &lemma);
+
+	// remove lemma from partner indices
+	void retire(std::size_t position);
+
+	// is expression substitution instance of some active lemma from `axioms_`?
+	bool is_subsumed(const Expression &expression);
+
+	// drop lemmas of generation and memory of its arena
+	void release_generation(std::size_t generation);
+
+	// index of target which is instance of expression, INVALID_INDEX if there is none
+	std::size_t proved_target(const Expression &expression) const;
+
+	// is any target an instance of expression?
 	bool is_target_proved_by(const Expression &expression) const;
 
 	// determine whether expression is good or not based on heuristic function
@@ -62,11 +260,37 @@ class Solver
 public:
 	Solver(std::vector<Expression> axioms,
 		Expression target,
-		std::uint64_t time_limit_ms = 60000
+		std::uint64_t time_limit_ms = 60000,
+		std::size_t threads = 1
 	);
 
+	// switch to given-clause search driven by `weight`
+	void set_weight(weight_t weight, std::size_t age_ratio = 5);
+
+	// chain backward from targets up to `depth` steps after every
+	// breadth-first generation, 0 turns it off
+	void set_backward(std::size_t depth = 6);
+
 	void solve();
 	std::string thought_chain() const;
+
+	/**
+	 * @brief is lemma whose canonical fingerprint is already known kept anyway?
+	 *
+	 * @note known twin differs at most by variable naming and order of
+	 * commutative operands; proofs are syntactic, so reordered duplicate
+	 * is kept when it proves one of `targets` as it is written
+	 */
+	static bool keeps_reordered_duplicate(
+		const Expression &duplicate,
+		const std::vector<Expression> &targets
+	);
+
+	// hits and misses of the shared modus ponens memo
+	ModusPonensCache::Statistics cache_statistics() const noexcept;
+
+	// lemmas admitted without dedup because fingerprint set reached its bound
+	std::size_t dedup_overflows() const noexcept;
 };
 
 #endif // SOLVER_HPP
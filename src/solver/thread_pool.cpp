@@ -0,0 +1,168 @@
+#include <algorithm>
+#include "thread_pool.hpp"
+
+
+WorkStealingPool::WorkStealingPool(std::size_t threads)
+	: queues_()
+	, threads_()
+	, mutex_()
+	, wake_()
+	, done_()
+	, task_(nullptr)
+	, round_(0)
+	, running_(0)
+	, stop_(false)
+{
+	threads = std::max<std::size_t>(threads, 1);
+
+	queues_.reserve(threads);
+	for (std::size_t i = 0; i < threads; ++i)
+	{
+		queues_.push_back(std::make_unique<Queue>());
+	}
+
+	// worker 0 is the thread which calls `parallel_for`
+	threads_.reserve(threads - 1);
+	for (std::size_t i = 1; i < threads; ++i)
+	{
+		threads_.emplace_back(&WorkStealingPool::work, this, i);
+	}
+}
+
+
+WorkStealingPool::~WorkStealingPool()
+{
+	{
+		std::lock_guard lock(mutex_);
+		stop_ = true;
+	}
+
+	wake_.notify_all();
+	for (auto &thread : threads_)
+	{
+		thread.join();
+	}
+}
+
+
+bool WorkStealingPool::take(std::size_t worker, range_t &range)
+{
+	{
+		auto &own = *queues_[worker];
+		std::lock_guard lock(own.mutex);
+
+		if (!own.ranges.empty())
+		{
+			range = own.ranges.front();
+			own.ranges.pop_front();
+			return true;
+		}
+	}
+
+	for (std::size_t i = 1; i < queues_.size(); ++i)
+	{
+		auto &victim = *queues_[(worker + i) % queues_.size()];
+		std::lock_guard lock(victim.mutex);
+
+		if (!victim.ranges.empty())
+		{
+			range = victim.ranges.back();
+			victim.ranges.pop_back();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+void WorkStealingPool::drain(std::size_t worker)
+{
+	range_t range;
+	while (take(worker, range))
+	{
+		for (auto i = range.first; i < range.second; ++i)
+		{
+			(*task_)(i);
+		}
+	}
+}
+
+
+void WorkStealingPool::work(std::size_t worker)
+{
+	std::uint64_t seen = 0;
+
+	while (true)
+	{
+		{
+			std::unique_lock lock(mutex_);
+			wake_.wait(lock, [&] { return stop_ || round_ != seen; });
+
+			if (stop_)
+			{
+				return;
+			}
+
+			seen = round_;
+		}
+
+		drain(worker);
+
+		{
+			std::lock_guard lock(mutex_);
+			--running_;
+		}
+
+		done_.notify_one();
+	}
+}
+
+
+void WorkStealingPool::parallel_for(
+	std::size_t count,
+	const std::function<void(std::size_t)> &task
+)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	if (threads_.empty())
+	{
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			task(i);
+		}
+
+		return;
+	}
+
+	// chunks are dealt round robin, so every queue starts with a fair share
+	const auto chunks = std::min(count, size() * CHUNKS_PER_THREAD);
+	const auto chunk = (count + chunks - 1) / chunks;
+
+	std::size_t next = 0;
+	for (std::size_t first = 0; first < count; first += chunk, ++next)
+	{
+		auto &queue = *queues_[next % size()];
+		std::lock_guard lock(queue.mutex);
+		queue.ranges.emplace_back(first, std::min(first + chunk, count));
+	}
+
+	{
+		std::lock_guard lock(mutex_);
+		task_ = &task;
+		running_ = threads_.size();
+		++round_;
+	}
+
+	wake_.notify_all();
+	drain(0);
+
+	// queues are empty now, but other workers may still run their last chunk
+	std::unique_lock lock(mutex_);
+	done_.wait(lock, [&] { return running_ == 0; });
+	task_ = nullptr;
+}
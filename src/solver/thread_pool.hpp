@@ -0,0 +1,70 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+
+/**
+ * @brief Fixed set of threads which run index loops with work stealing
+ *
+ * @note index range is cut into chunks which are dealt to per-thread
+ * queues; thread takes chunks from the front of its own queue and,
+ * when it is empty, steals from the back of others. Calling thread
+ * takes part as worker 0, so pool of one thread spawns nothing
+ */
+class WorkStealingPool
+{
+	using range_t = std::pair<std::size_t, std::size_t>;
+
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<range_t> ranges;
+	};
+
+	// chunks per thread, more chunks balance better but cost more locking
+	static constexpr std::size_t CHUNKS_PER_THREAD = 8;
+
+	std::vector<std::unique_ptr<Queue>> queues_;
+	std::vector<std::thread> threads_;
+
+	std::mutex mutex_;
+	std::condition_variable wake_;
+	std::condition_variable done_;
+
+	// task of current loop, `round_` is advanced when a loop is started
+	const std::function<void(std::size_t)> *task_;
+	std::uint64_t round_;
+	std::size_t running_;
+	bool stop_;
+
+	// take chunk of own queue or steal one from another queue
+	bool take(std::size_t worker, range_t &range);
+
+	// run chunks until every queue is empty
+	void drain(std::size_t worker);
+
+	void work(std::size_t worker);
+public:
+	explicit WorkStealingPool(std::size_t threads = 1);
+	~WorkStealingPool();
+
+	WorkStealingPool(const WorkStealingPool &) = delete;
+	WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+	// number of threads including calling one
+	inline std::size_t size() const noexcept { return queues_.size(); }
+
+	// call `task(i)` for every i in [0, count) and wait for all of them,
+	// calls are independent and may run in any order
+	void parallel_for(std::size_t count, const std::function<void(std::size_t)> &task);
+};
+
+#endif // THREAD_POOL_HPP
@@ -0,0 +1,135 @@
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include "weight.hpp"
+
+
+// number of function nodes
+static std::size_t functions(const Summary &summary) noexcept
+{
+	return std::accumulate(
+		summary.operations.begin(),
+		summary.operations.end(),
+		std::size_t{0}
+	);
+}
+
+
+weight_t size_weight()
+{
+	return [] (const Expression &lemma, const std::vector<Expression> &) -> double
+	{
+		return static_cast<double>(lemma.size());
+	};
+}
+
+
+weight_t depth_weight()
+{
+	return [] (const Expression &lemma, const std::vector<Expression> &) -> double
+	{
+		return static_cast<double>(lemma.summary().depth);
+	};
+}
+
+
+weight_t symbol_weight(std::array<double, 7> operations, double constant, double variable)
+{
+	return [=] (const Expression &lemma, const std::vector<Expression> &) -> double
+	{
+		double weight = 0.0;
+		for (std::size_t i = 0; i < operations.size(); ++i)
+		{
+			weight += operations[i] * static_cast<double>(lemma.summary().operations[i]);
+		}
+
+		// leaves are counted one by one, summary keeps only variable mask
+		for (std::size_t i = 0; i < lemma.size(); ++i)
+		{
+			if (lemma[i].type == term_t::Constant)
+			{
+				weight += constant;
+			}
+			else if (lemma[i].type == term_t::Variable)
+			{
+				weight += variable;
+			}
+		}
+
+		return weight;
+	};
+}
+
+
+weight_t target_weight(double factor)
+{
+	return [=] (const Expression &lemma, const std::vector<Expression> &targets) -> double
+	{
+		const auto &summary = lemma.summary();
+		const auto leaves = static_cast<double>(lemma.size() - functions(summary));
+
+		double distance = targets.empty() ? 0.0 : std::numeric_limits<double>::max();
+		for (const auto &target : targets)
+		{
+			const auto &other = target.summary();
+			const auto other_leaves = static_cast<double>(target.size() - functions(other));
+
+			double current = std::abs(leaves - other_leaves) +
+				std::abs(static_cast<double>(summary.depth) - static_cast<double>(other.depth));
+
+			for (std::size_t i = 0; i < summary.operations.size(); ++i)
+			{
+				current += std::abs(
+					static_cast<double>(summary.operations[i]) -
+					static_cast<double>(other.operations[i])
+				);
+			}
+
+			distance = std::min(distance, current);
+		}
+
+		return static_cast<double>(lemma.size()) + factor * distance;
+	};
+}
+
+
+weight_t combined_weight(std::vector<std::pair<double, weight_t>> weights)
+{
+	return [weights = std::move(weights)] (
+		const Expression &lemma,
+		const std::vector<Expression> &targets
+	) -> double
+	{
+		double weight = 0.0;
+		for (const auto &[factor, part] : weights)
+		{
+			weight += factor * part(lemma, targets);
+		}
+
+		return weight;
+	};
+}
+
+
+weight_t weight_by_name(std::string_view name)
+{
+	if (name == "size")
+	{
+		return size_weight();
+	}
+	if (name == "depth")
+	{
+		return depth_weight();
+	}
+	if (name == "symbols")
+	{
+		// negations and implications are cheap, derived operations are rare
+		return symbol_weight({1.0, 1.0, 1.0, 2.0, 2.0, 3.0, 3.0});
+	}
+	if (name == "target")
+	{
+		return target_weight();
+	}
+
+	return {};
+}
@@ -0,0 +1,52 @@
+#ifndef WEIGHT_HPP
+#define WEIGHT_HPP
+
+#include <array>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <string_view>
+#include "../math/ast.hpp"
+
+
+/**
+ * @brief Weight of passive lemma in given-clause search,
+ * lemma with the smallest weight is processed first
+ *
+ * @note weight is computed once, when lemma is produced,
+ * `targets` are the goals left after deduction theorem
+ */
+using weight_t = std::function<double(
+	const Expression &lemma,
+	const std::vector<Expression> &targets
+)>;
+
+
+// number of nodes
+weight_t size_weight();
+
+// longest root-to-leaf path
+weight_t depth_weight();
+
+// sum of symbol costs, function nodes are charged by their operation
+weight_t symbol_weight(
+	std::array<double, 7> operations,
+	double constant = 1.0,
+	double variable = 1.0
+);
+
+/**
+ * @brief size plus distance to the closest target
+ *
+ * @note distance compares summaries only: operation counts, depth
+ * and number of leaves, so it costs nothing per node
+ */
+weight_t target_weight(double factor = 1.0);
+
+// weighted sum of other weights
+weight_t combined_weight(std::vector<std::pair<double, weight_t>> weights);
+
+// weight by its name: size, depth, symbols or target; empty if name is unknown
+weight_t weight_by_name(std::string_view name);
+
+#endif // WEIGHT_HPP
@@ -1,13 +1,17 @@
 #include <iostream>
 #include <vector>
+#include <string>
 #include "./math/ast.hpp"
 #include "./math/rules.hpp"
 #include "./solver/solver.hpp"
 #include "./math/helper.hpp"
 
 
-int main()
+int main(int argc, char *argv[])
 {
+	// optional number of threads which generate lemmas and weight name or mode
+	const std::size_t threads = argc > 1 ? std::stoul(argv[1]) : 1;
+
 	std::string expression_str;
 	std::cin >> expression_str;
 	Expression target(expression_str);
@@ -23,9 +27,33 @@ int main()
 	std::cout << "input: " << expression_str << '\n';
 	std::cout << "normalized input: " << target << "\n\n";
 
-	Solver solve(axioms, target);
+	Solver solve(axioms, target, 60000, threads);
+
+	// optional weight switches to given-clause search,
+	// `backward` adds goal-directed rounds to breadth-first one
+	if (argc > 2 && std::string(argv[2]) == "backward")
+	{
+		solve.set_backward();
+	}
+	else if (argc > 2)
+	{
+		auto weight = weight_by_name(argv[2]);
+		if (!weight)
+		{
+			std::cerr << "[-] error: unknown weight " << argv[2] << '\n';
+			return 1;
+		}
+
+		solve.set_weight(std::move(weight));
+	}
 	solve.solve();
 
+	// fingerprint set reached its bound, so some duplicates were searched again
+	if (const auto overflows = solve.dedup_overflows(); overflows != 0)
+	{
+		std::cerr << "[!] warning: " << overflows << " lemmas were admitted without dedup\n";
+	}
+
 	std::cout << solve.thought_chain() << '\n';
 	return 0;
 }
@@ -0,0 +1,123 @@
+#include <iostream>
+#include <cassert>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "../math/fingerprint_set.hpp"
+
+
+// distinct keys, zero words included since they are reserved internally
+static Fingerprint key(std::size_t i)
+{
+	return {i * 0x9e3779b97f4a7c15ull, i % 7 == 0 ? 0 : i};
+}
+
+
+// keys are stored once and found afterwards
+void test_single_thread()
+{
+	FingerprintSet set(16);
+
+	for (std::size_t i = 0; i < 10000; ++i)
+	{
+		assert(set.insert(key(i)));
+		assert(!set.insert(key(i)));
+	}
+
+	for (std::size_t i = 0; i < 10000; ++i)
+	{
+		assert(set.contains(key(i)));
+	}
+
+	assert(!set.contains(key(10000)));
+	assert(set.size() == 10000);
+	assert(set.overflows() == 0);
+
+	std::cout << "Test single thread passed." << std::endl;
+}
+
+
+// threads insert the same keys while tables grow
+void test_concurrent_inserts()
+{
+	constexpr std::size_t THREADS = 8;
+	constexpr std::size_t KEYS = 1 << 16;
+
+	FingerprintSet set(16);
+	std::vector<std::atomic<std::size_t>> reported(KEYS);
+	std::vector<std::thread> threads;
+
+	for (std::size_t t = 0; t < THREADS; ++t)
+	{
+		threads.emplace_back([&, t]
+		{
+			// every thread walks keys from its own start, so they collide often
+			for (std::size_t k = 0; k < KEYS; ++k)
+			{
+				const auto i = (k + t * KEYS / THREADS) % KEYS;
+				if (set.insert(key(i)))
+				{
+					reported[i].fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+		});
+	}
+
+	for (auto &thread : threads)
+	{
+		thread.join();
+	}
+
+	// key may be reported twice only when it raced with a resize
+	std::size_t duplicates = 0;
+	for (std::size_t i = 0; i < KEYS; ++i)
+	{
+		assert(reported[i] >= 1);
+		assert(set.contains(key(i)));
+		duplicates += reported[i] - 1;
+	}
+
+	assert(set.size() >= KEYS && set.size() == KEYS + duplicates);
+	assert(set.overflows() == 0);
+
+	// once stored, key is never new again
+	for (std::size_t i = 0; i < KEYS; ++i)
+	{
+		assert(!set.insert(key(i)));
+	}
+
+	std::cout << "Test concurrent inserts passed." << std::endl;
+}
+
+
+// keys beyond the bound are counted, not silently admitted
+void test_overflow()
+{
+	FingerprintSet set(16, 16);
+
+	std::size_t admitted = 0;
+	for (std::size_t i = 0; i < 100; ++i)
+	{
+		admitted += set.insert(key(i));
+	}
+
+	assert(admitted == 100);
+	assert(set.overflows() > 0);
+	assert(set.size() + set.overflows() == 100);
+
+	set.clear();
+	assert(set.size() == 0 && set.overflows() == 0);
+
+	std::cout << "Test overflow passed." << std::endl;
+}
+
+
+int main()
+{
+	test_single_thread();
+	test_concurrent_inserts();
+	test_overflow();
+
+	std::cout << "All tests passed." << std::endl;
+	return 0;
+}
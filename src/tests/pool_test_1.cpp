@@ -0,0 +1,55 @@
+#include <iostream>
+#include <cassert>
+#include <thread>
+#include "../math/ast.hpp"
+#include "../math/pool.hpp"
+
+
+// equal formulas share id and are built back from it
+void test_intern_and_rebuild()
+{
+	ExpressionPool pool;
+
+	Expression first("(a>b)>(!a*b)");
+	Expression second("(a>b)>(!a*b)");
+	Expression other("(a>b)>(a*b)");
+
+	const auto id = pool.intern(first);
+	assert(pool.intern(second) == id);
+	assert(pool.intern(other) != id);
+	assert(pool.find(second) == id);
+	assert(pool.find(Expression("a>c")) == ExpressionPool::INVALID_ID);
+
+	auto rebuilt = pool.expression(id);
+	assert(rebuilt.to_string() == first.to_string());
+
+	std::cout << "Test intern and rebuild passed." << std::endl;
+}
+
+
+// cleared pool forgets expressions and may be interned by another thread
+void test_clear()
+{
+	ExpressionPool pool;
+	pool.intern(Expression("a>b"));
+	assert(pool.size() == 3);
+
+	pool.clear();
+	assert(pool.size() == 0);
+	assert(pool.find(Expression("a>b")) == ExpressionPool::INVALID_ID);
+
+	std::thread([&] { pool.intern(Expression("a>b")); }).join();
+	assert(pool.size() == 3);
+
+	std::cout << "Test clear passed." << std::endl;
+}
+
+
+int main()
+{
+	test_intern_and_rebuild();
+	test_clear();
+
+	std::cout << "All tests passed." << std::endl;
+	return 0;
+}
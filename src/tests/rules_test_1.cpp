@@ -0,0 +1,172 @@
+#include <iostream>
+#include <cassert>
+#include <vector>
+#include "../math/ast.hpp"
+#include "../math/rules.hpp"
+#include "../math/helper.hpp"
+
+
+// leaves of `expression` become constants (hypotheses)
+static Expression constant(std::string_view expression)
+{
+	Expression result(expression);
+	result.make_permanent();
+	return result;
+}
+
+
+static Expression implication(const Expression &lhs, const Expression &rhs)
+{
+	return Expression::construct(lhs, operation_t::Implication, rhs);
+}
+
+
+// constant with the same number as a variable is not an occurrence of it
+void test_occurs_check_ignores_constants()
+{
+	const Expression minor("a>b");
+
+	for (const auto name : {"a", "i"})
+	{
+		// ((x>C)>D)>D, where x is a constant
+		const auto major = implication(
+			implication(implication(constant(name), Expression("c")), Expression("d")),
+			Expression("d")
+		);
+
+		auto result = modus_ponens(minor, major);
+		assert(!result.empty());
+		assert(result.to_string() == "A");
+	}
+
+	std::cout << "Test occurs check ignores constants passed." << std::endl;
+}
+
+
+// variable bound to a formula which contains it is still rejected
+void test_occurs_check_rejects_cycles()
+{
+	// A>A and B>(B>C) unify only if B = B>C
+	assert(modus_ponens(Expression("a>a"), Expression("(a>(a>b))>b")).empty());
+
+	std::cout << "Test occurs check rejects cycles passed." << std::endl;
+}
+
+
+// modus ponens through the unifier only, as it is done for non-ground pairs
+static Expression unified_modus_ponens(const Expression &lhs, const Expression &rhs)
+{
+	if (lhs.empty() || rhs.empty() || rhs[0].op != operation_t::Implication)
+	{
+		return {};
+	}
+
+	const auto consequent = ExpressionView(rhs, rhs.subtree(0).right()).shifted(
+		static_cast<value_t>(lhs.max_value() + 1 - rhs.min_value())
+	);
+
+	auto &context = UnificationContext::local();
+	if (!context.unify(lhs, ExpressionView(rhs, rhs.subtree(0).left()), consequent.max_value()))
+	{
+		return {};
+	}
+
+	return context.instantiate(consequent, true);
+}
+
+
+// premises of the samples: schemas, hypotheses and formulas mixing both
+static std::vector<Expression> premises()
+{
+	std::vector<Expression> result;
+
+	for (const auto schema : {
+		"a>(b>a)", "(a>(b>c))>((a>b)>(a>c))", "(!a>!b)>((!a>b)>a)", "(!a>!b)>(b>a)",
+		"a>a", "!a>(a>b)", "(a>b)>((b>c)>(a>c))", "a", "!a", "a>b", "!a>b"
+	})
+	{
+		Expression expression(schema);
+		expression.normalize();
+		result.push_back(expression);
+	}
+
+	for (const auto hypothesis : {
+		"a", "!a", "b", "a>b", "!a>b", "b>a", "a>(b>a)", "(a>b)>c", "!b>!a", "(a>c)>((b>c)>((!a>b)>c))"
+	})
+	{
+		result.push_back(constant(hypothesis));
+	}
+
+	// mixed: hypothesis in place of a schema operand
+	const auto a = constant("a");
+	Expression variable("a");
+	variable.normalize();
+
+	result.push_back(implication(a, variable));
+	result.push_back(implication(variable, a));
+	result.push_back(implication(implication(a, variable), variable));
+
+	return result;
+}
+
+
+// fast paths of modus ponens give the same results as the unifier
+void test_ground_paths_agree_with_unifier()
+{
+	const auto formulas = premises();
+
+	std::size_t applied = 0;
+	for (const auto &lhs : formulas)
+	{
+		for (const auto &rhs : formulas)
+		{
+			auto fast = modus_ponens(lhs, rhs);
+			auto general = unified_modus_ponens(lhs, rhs);
+
+			assert(fast.empty() == general.empty());
+			if (!fast.empty())
+			{
+				assert(fast.to_string() == general.to_string());
+				++applied;
+			}
+		}
+	}
+
+	assert(applied > 0);
+
+	std::cout << "Test ground paths agree with unifier passed." << std::endl;
+}
+
+
+// variables created when two variables are unified don't meet consequent ones
+void test_fresh_variables_stay_apart()
+{
+	Expression minor("a");
+	Expression major("a>(b>a)");
+	minor.normalize();
+	major.normalize();
+
+	// A, A>(B>A) ⊢ B>A
+	assert(modus_ponens(minor, major).to_string() == "A>B");
+
+	minor = Expression("a>a");
+	major = Expression("(a>b)>((b>c)>(a>c))");
+	minor.normalize();
+	major.normalize();
+
+	assert(modus_ponens(minor, major).to_string() == "(A>B)>(A>B)");
+
+	std::cout << "Test fresh variables stay apart passed." << std::endl;
+}
+
+
+int main()
+{
+	test_occurs_check_ignores_constants();
+	test_occurs_check_rejects_cycles();
+	test_fresh_variables_stay_apart();
+	test_ground_paths_agree_with_unifier();
+
+	std::cout << "All tests passed." << std::endl;
+	return 0;
+}
@@ -0,0 +1,89 @@
+#include <iostream>
+#include <cassert>
+#include <vector>
+#include <string>
+#include "../math/ast.hpp"
+#include "../math/rules.hpp"
+#include "../math/schema.hpp"
+
+
+// normalized schema or hypothesis, the way solver keeps its lemmas
+static Expression lemma(std::string_view expression, bool ground = false)
+{
+	Expression result(expression);
+	result.normalize();
+
+	if (ground)
+	{
+		result.make_permanent();
+	}
+
+	return result;
+}
+
+
+// compiled schemas and modus ponens give the same results,
+// Unknown falls back to modus ponens the way solver does
+void test_schemas_agree_with_modus_ponens()
+{
+	std::vector<Expression> schemas;
+	for (const auto schema : {
+		"a>(b>a)", "(a>(b>c))>((a>b)>(a>c))", "(!a>!b)>((!a>b)>a)",
+		"(!a>!b)>(b>a)", "(a>b)>((b>c)>(a>c))", "!a>(a>b)", "(a>a)>b"
+	})
+	{
+		schemas.push_back(lemma(schema));
+	}
+
+	std::vector<Expression> minors;
+	for (const auto minor : {
+		"a", "!a", "a>a", "a>b", "!a>!b", "!a>b", "a>(b>a)", "a>(b>c)",
+		"(a>b)>c", "(a>(b>c))>((a>b)>(a>c))", "!a>!!b", "(!a>!b)>(b>a)"
+	})
+	{
+		minors.push_back(lemma(minor));
+		minors.push_back(lemma(minor, true));
+	}
+
+	std::size_t outcomes[3] = {};
+	for (const auto &schema : schemas)
+	{
+		const CompiledSchema compiled(schema);
+
+		for (const auto &minor : minors)
+		{
+			auto expected = modus_ponens(minor, schema);
+
+			Expression result;
+			const auto outcome = compiled.apply(minor, result);
+			++outcomes[static_cast<std::size_t>(outcome)];
+
+			switch (outcome)
+			{
+			case CompiledSchema::result_t::Match:
+				assert(!expected.empty());
+				assert(result.to_string() == expected.to_string());
+				break;
+			case CompiledSchema::result_t::Mismatch:
+				assert(expected.empty());
+				break;
+			case CompiledSchema::result_t::Unknown:
+				break;
+			}
+		}
+	}
+
+	// every outcome is exercised
+	assert(outcomes[0] > 0 && outcomes[1] > 0 && outcomes[2] > 0);
+
+	std::cout << "Test schemas agree with modus ponens passed." << std::endl;
+}
+
+
+int main()
+{
+	test_schemas_agree_with_modus_ponens();
+
+	std::cout << "All tests passed." << std::endl;
+	return 0;
+}
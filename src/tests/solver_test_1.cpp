@@ -0,0 +1,65 @@
+#include <iostream>
+#include <cassert>
+#include <vector>
+#include "../math/ast.hpp"
+#include "../solver/solver.hpp"
+
+
+static Expression constant(std::string_view expression)
+{
+	Expression result(expression);
+	result.make_permanent();
+	return result;
+}
+
+
+// canonical form ignores order of commutative operands only,
+// negation is polarity of a leaf and takes part in the order
+void test_canonical_fingerprint()
+{
+	assert(constant("(b*a)>c").canonical_fingerprint() == constant("(a*b)>c").canonical_fingerprint());
+	assert(constant("(!b*a)>c").canonical_fingerprint() == constant("(a*!b)>c").canonical_fingerprint());
+	assert(constant("(b>a)>c").canonical_fingerprint() != constant("(a>b)>c").canonical_fingerprint());
+	assert(constant("(!a*b)>c").canonical_fingerprint() != constant("(a*!b)>c").canonical_fingerprint());
+
+	std::cout << "Test canonical fingerprint passed." << std::endl;
+}
+
+
+// duplicate modulo operand order survives only when it proves a target as written
+void test_reordered_duplicate()
+{
+	const std::vector<Expression> targets = {constant("(b*a)>c")};
+
+	// reordered and proves target
+	assert(Solver::keeps_reordered_duplicate(constant("(b*a)>c"), targets));
+
+	// general lemma proves its instance, in either order of operands
+	Expression reordered("((a>b)*c)>d");
+	Expression ordered("(c*(a>b))>d");
+	reordered.normalize();
+	ordered.normalize();
+
+	assert(Solver::keeps_reordered_duplicate(reordered, {constant("((a>b)*c)>a")}));
+	assert(Solver::keeps_reordered_duplicate(ordered, {constant("(c*(a>b))>a")}));
+
+	// proofs are syntactic: other order doesn't prove the target
+	assert(!Solver::keeps_reordered_duplicate(constant("(a*b)>c"), targets));
+	assert(!Solver::keeps_reordered_duplicate(ordered, {constant("((a>b)*c)>a")}));
+
+	// reordered, but proves nothing
+	assert(!Solver::keeps_reordered_duplicate(constant("(b*a)>c"), {constant("c")}));
+	assert(!Solver::keeps_reordered_duplicate(constant("(b*a)>c"), {}));
+
+	std::cout << "Test reordered duplicate passed." << std::endl;
+}
+
+
+int main()
+{
+	test_canonical_fingerprint();
+	test_reordered_duplicate();
+
+	std::cout << "All tests passed." << std::endl;
+	return 0;
+}
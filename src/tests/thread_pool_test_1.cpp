@@ -0,0 +1,105 @@
+#include <iostream>
+#include <cassert>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "../solver/thread_pool.hpp"
+#include "../solver/solver.hpp"
+
+
+// every index runs exactly once, whatever the count and number of workers
+void test_each_item_runs_once()
+{
+	for (const std::size_t threads : {1, 4})
+	{
+		WorkStealingPool pool(threads);
+		assert(pool.size() == threads);
+
+		// pool is reused across loops, counts are below, at and above chunk count
+		for (const std::size_t count : {0, 1, 3, 32, 33, 1000, 10007})
+		{
+			std::vector<std::atomic<std::size_t>> runs(count);
+
+			pool.parallel_for(count, [&] (std::size_t i)
+			{
+				runs[i].fetch_add(1, std::memory_order_relaxed);
+			});
+
+			for (const auto &item : runs)
+			{
+				assert(item.load() == 1);
+			}
+		}
+	}
+
+	std::cout << "Test each item runs once passed." << std::endl;
+}
+
+
+// slow chunks of one queue are stolen, so every worker still finishes
+void test_uneven_items()
+{
+	WorkStealingPool pool(4);
+	std::vector<std::atomic<std::size_t>> runs(256);
+
+	pool.parallel_for(runs.size(), [&] (std::size_t i)
+	{
+		if (i < 32)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		runs[i].fetch_add(1, std::memory_order_relaxed);
+	});
+
+	for (const auto &item : runs)
+	{
+		assert(item.load() == 1);
+	}
+
+	std::cout << "Test uneven items passed." << std::endl;
+}
+
+
+// candidates are merged in order, so proof doesn't depend on number of threads
+void test_solver_output_is_deterministic()
+{
+	const std::vector<Expression> axioms = {
+		Expression("a>(b>a)"),
+		Expression("(a>(b>c))>((a>b)>(a>c))"),
+		Expression("(!a>!b)>((!a>b)>a)")
+	};
+
+	for (const auto input : {"(a>c)>((b>c)>((a|b)>c))", "a>(b>(a*b))"})
+	{
+		std::string chains[2];
+
+		for (const std::size_t threads : {1, 4})
+		{
+			Expression target(input);
+			target.standardize();
+			target.make_permanent();
+
+			Solver solver(axioms, target, 60000, threads);
+			solver.solve();
+			chains[threads == 1 ? 0 : 1] = solver.thought_chain();
+		}
+
+		assert(chains[0].find("No proof") == std::string::npos);
+		assert(chains[0] == chains[1]);
+	}
+
+	std::cout << "Test solver output is deterministic passed." << std::endl;
+}
+
+
+int main()
+{
+	test_each_item_runs_once();
+	test_uneven_items();
+	test_solver_output_is_deterministic();
+
+	std::cout << "All tests passed." << std::endl;
+	return 0;
+}